@@ -0,0 +1,41 @@
+#include "Arena.h"
+#include <algorithm>
+
+Arena::Arena(std::size_t block_size) : block_size_(block_size) {}
+
+void* Arena::Allocate(std::size_t bytes, std::size_t alignment) {
+	while (current_ < blocks_.size()) {
+		auto& block = blocks_[current_];
+		auto offset = (offset_ + alignment - 1) / alignment * alignment;
+		if (offset + bytes <= block.size) {
+			offset_ = offset + bytes;
+			used_ += bytes;
+			return block.data.get() + offset;
+		}
+		++current_;
+		offset_ = 0;
+	}
+
+	// operator new[] aligns for any fundamental type
+	auto size = std::max(block_size_, bytes);
+	blocks_.push_back({std::unique_ptr<char[]>(new char[size]), size});
+	current_ = blocks_.size() - 1;
+	offset_ = bytes;
+	used_ += bytes;
+	return blocks_.back().data.get();
+}
+
+void Arena::Release() {
+	// One block large enough for the whole turn serves the next one
+	if (blocks_.size() > 1) {
+		std::size_t size = 0;
+		for (const auto& block : blocks_) {
+			size += block.size;
+		}
+		blocks_.clear();
+		blocks_.push_back({std::unique_ptr<char[]>(new char[size]), size});
+	}
+	current_ = 0;
+	offset_ = 0;
+	used_ = 0;
+}
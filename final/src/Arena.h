@@ -0,0 +1,86 @@
+#pragma once
+#include "Matrix.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <set>
+
+// Monotonic allocator for the temporaries of one turn. Memory is handed out
+// from large blocks and is only freed all at once by Release, which keeps
+// the blocks around for the next turn.
+class Arena {
+public:
+	explicit Arena(std::size_t block_size = 1 << 16);
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	void* Allocate(std::size_t bytes, std::size_t alignment);
+
+	// Everything allocated so far must be destroyed by now
+	void Release();
+
+	// @return	bytes handed out since the last Release
+	std::size_t Used() const { return used_; }
+
+private:
+	struct Block {
+		std::unique_ptr<char[]> data;
+		std::size_t size;
+	};
+
+	std::size_t block_size_;
+	std::vector<Block> blocks_;
+	std::size_t current_ = 0;	// block in use
+	std::size_t offset_ = 0;	// in the block in use
+	std::size_t used_ = 0;
+};
+
+// Standard allocator over an Arena, or over the heap without one, so that
+// the same container types serve both
+template<typename T>
+class ArenaAllocator {
+public:
+	using value_type = T;
+
+	ArenaAllocator(Arena* arena = nullptr) : arena_(arena) {}
+
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.GetArena()) {}
+
+	T* allocate(std::size_t n) {
+		if (arena_) {
+			return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+		}
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+
+	void deallocate(T* p, std::size_t) {
+		if (!arena_) {
+			::operator delete(p);
+		}
+	}
+
+	Arena* GetArena() const { return arena_; }
+
+private:
+	Arena* arena_;
+};
+
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+	return lhs.GetArena() == rhs.GetArena();
+}
+
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+	return !(lhs == rhs);
+}
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+template<typename T>
+using ArenaSet = std::set<T, std::less<T>, ArenaAllocator<T>>;
+
+template<typename T>
+using ArenaMatrix = Matrix<T, ArenaAllocator<T>>;
@@ -0,0 +1,81 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Queue of byte records from one producer thread to one consumer thread,
+// without locks. Records are copied into a ring of fixed capacity.
+class ByteQueue {
+public:
+	// @param capacity	rounded up to a power of two
+	explicit ByteQueue(std::size_t capacity) {
+		std::size_t size = 64;
+		while (size < capacity) {
+			size *= 2;
+		}
+		ring_.resize(size);
+	}
+
+	ByteQueue(const ByteQueue&) = delete;
+	ByteQueue& operator=(const ByteQueue&) = delete;
+
+	// @return	false if there is no room for the record now
+	bool Push(const char* data, std::size_t size) {
+		auto tail = tail_.load(std::memory_order_relaxed);
+		auto head = head_.load(std::memory_order_acquire);
+		if (ring_.size() - (tail - head) < sizeof(std::uint32_t) + size) {
+			return false;
+		}
+		std::uint32_t length = size;
+		Copy(tail, reinterpret_cast<const char*>(&length), sizeof(length));
+		Copy(tail + sizeof(length), data, size);
+		tail_.store(tail + sizeof(length) + size, std::memory_order_release);
+		return true;
+	}
+
+	// Replaces out with the oldest record, keeping its capacity
+	// @return	false if the queue is empty
+	bool Pop(std::string& out) {
+		auto head = head_.load(std::memory_order_relaxed);
+		auto tail = tail_.load(std::memory_order_acquire);
+		if (head == tail) {
+			return false;
+		}
+		std::uint32_t length;
+		Read(head, reinterpret_cast<char*>(&length), sizeof(length));
+		out.resize(length);
+		Read(head + sizeof(length), &out[0], length);
+		head_.store(head + sizeof(length) + length, std::memory_order_release);
+		return true;
+	}
+
+	// @return	true if a record of size can ever fit
+	bool Fits(std::size_t size) const {
+		return sizeof(std::uint32_t) + size <= ring_.size();
+	}
+
+private:
+	void Copy(std::size_t index, const char* data, std::size_t size) {
+		auto mask = ring_.size() - 1;
+		auto first = std::min(size, ring_.size() - (index & mask));
+		std::memcpy(&ring_[index & mask], data, first);
+		std::memcpy(&ring_[0], data + first, size - first);
+	}
+
+	void Read(std::size_t index, char* data, std::size_t size) const {
+		auto mask = ring_.size() - 1;
+		auto first = std::min(size, ring_.size() - (index & mask));
+		std::memcpy(data, &ring_[index & mask], first);
+		std::memcpy(data + first, &ring_[0], size - first);
+	}
+
+	std::vector<char> ring_;
+	// Bytes pushed and popped so far, the ring index is their low bits
+	std::atomic<std::size_t> head_{0};
+	std::atomic<std::size_t> tail_{0};
+};
@@ -0,0 +1,15 @@
+#pragma once
+#include <atomic>
+#include <memory>
+
+// Lets one thread stop a search running on another. Copies share the flag.
+class CancelToken {
+public:
+	CancelToken() : cancelled_(std::make_shared<std::atomic<bool>>(false)) {}
+
+	void Cancel() const { *cancelled_ = true; }
+	bool Cancelled() const { return *cancelled_; }
+
+private:
+	std::shared_ptr<std::atomic<bool>> cancelled_;
+};
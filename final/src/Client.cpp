@@ -1,9 +1,18 @@
 #include "Client.h"
+#include "Log.h"
 #include <vector>
-#include <iostream>
 
 #include "fcntl.h"
 #include "string.h"
+#include <sys/uio.h>
+
+namespace {
+
+std::vector<std::string> ToStrings(const std::vector<boost::string_ref>& lines) {
+	return {lines.begin(), lines.end()};
+}
+
+} // namespace
 
 
 Client::Client(
@@ -22,7 +31,9 @@ Client::Client(
 		throw std::runtime_error("Error: Cannot find host: " + host_name);
 	}
 
-	output_.open(filename);
+	if (!filename.empty()) {
+		log_.reset(new MatchLogWriter(filename, IsBinaryLogName(filename)));
+	}
 	sockaddr_in socket_address;
 	socket_address.sin_family = AF_INET;
 	socket_address.sin_port = htons(port);
@@ -40,6 +51,8 @@ Client::Client(
 	flags |= O_NONBLOCK;
 	::fcntl(socket_handler_.get_handler(), F_SETFL, flags);
 
+	loop_.reset(new EventLoop(socket_handler_.get_handler()));
+
 	std::vector<std::string> login_messages;
 
 	login_messages.push_back(std::string("LOGIN ") + team_name + " " + password);
@@ -53,89 +66,111 @@ Client::Client(
 
 
 	for (auto x : login_response) {
-		std::cerr << "LOGIN RESPONSE:" <<  x << std::endl;
+		LOG(kInfo) << "LOGIN RESPONSE:" << x;
 	}
 }
 
 void Client::SendMessages(const std::vector<std::string>& messages) {
-	std::string message;
-
-	for(std::size_t i = 0; i < messages.size(); ++i) {
-		message += messages[i] + '\n';
+	static const char newline[] = "\n";
+	static const char end[] = ".\n";
+
+	std::vector<::iovec> parts;
+	parts.reserve(2 * messages.size() + 1);
+	std::size_t size = 0;
+	for (const auto& message : messages) {
+		parts.push_back({const_cast<char*>(message.data()), message.size()});
+		parts.push_back({const_cast<char*>(newline), 1});
+		size += message.size() + 1;
 	}
-	message += ".\n";
+	parts.push_back({const_cast<char*>(end), 2});
+	size += 2;
 
 	if (verbose_) {
-		std::cerr << "Will try to send: " << message << std::endl;
+		LOG(kDebug) << "Will try to send:";
+		for (const auto& message : messages) {
+			LOG(kDebug) << message;
+		}
 	}
-	BlockUntilMessageCanBeSent();
 
-	if (verbose_) {
-		std::cerr << "Sending message now" << std::endl;
-	}
+	// send as much as the socket takes, and wait for the rest
+	auto part = parts.begin();
+	std::size_t sent = 0;
+	while (part != parts.end()) {
+		::msghdr header{};
+		header.msg_iov = &*part;
+		header.msg_iovlen = parts.end() - part;
+		auto sent_bytes = ::sendmsg(socket_handler_.get_handler(), &header, 0);
+		if (sent_bytes < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				BlockUntilMessageCanBeSent();
+				continue;
+			}
+			if (errno == EINTR) {
+				continue;
+			}
+			LOG(kError) << "Cannot send message properly: " << ::strerror(errno)
+				<< logging::Kv("sent", sent) << logging::Kv("size", size)
+				<< ". Closing connection.";
+			socket_handler_.invalidate();
+			return;
+		}
 
-	int sent_bytes = send(socket_handler_.get_handler(), message.c_str(), message.size(), 0);
+		sent += sent_bytes;
+		std::size_t left = sent_bytes;
+		while (part != parts.end() && left >= part->iov_len) {
+			left -= part->iov_len;
+			++part;
+		}
+		if (left > 0) {
+			part->iov_base = static_cast<char*>(part->iov_base) + left;
+			part->iov_len -= left;
+		}
+	}
 
-	if(sent_bytes != (int)message.size()) {
-		std::cerr << "Warning: Cannot sent message properly: " << message << std::endl;
-		std::cerr << "errno is: " << ::strerror(errno) << std::endl;
-		std::cerr << sent_bytes << " byte sent from " <<
-			message.size() << ". Closing connection." << std::endl;
-		socket_handler_.invalidate();
+	if (verbose_) {
+		LOG(kDebug) << "Sent " << sent << " bytes";
 	}
 }
 
-boost::optional<std::vector<std::string>> Client::CheckForMessage() {
-	std::vector<std::string> result;
-	std::string buffer;
-
-	std::stringstream consumer(received_buffer_);
-	while(std::getline(consumer, buffer)) {
-		if(buffer == ".") {
-			auto position = consumer.tellg();
-			if (position != std::stringstream::pos_type{-1}) {
-				received_buffer_ = consumer.str().substr(position);
-			} else {
-				received_buffer_.clear();
-			}
-			return result;
-		} else if(!buffer.empty()) {
-			result.push_back(buffer);
+boost::optional<const Client::Lines&> Client::CheckForMessage() {
+	for (;;) {
+		if (framer_.Next(lines_)) {
+			return lines_;
 		}
-	}
-
-	int buf_size = 4096;
-	buffer = std::string(buf_size, '\0');
 
-	int received_bytes = recv(socket_handler_.get_handler(), &buffer[0], buf_size, 0);
+		auto space = framer_.WriteSpace();
+		auto received_bytes = recv(socket_handler_.get_handler(),
+			space.first, space.second, 0);
 
-	switch(received_bytes) {
-	case -1: {
-		auto error = errno;
-		if (error == EAGAIN || error == EWOULDBLOCK) {
-			return boost::none;
+		switch(received_bytes) {
+		case -1: {
+			auto error = errno;
+			if (error == EAGAIN || error == EWOULDBLOCK) {
+				return boost::none;
+			}
+			if (error == EINTR) {
+				continue;
+			}
+			LOG(kError) << "recv failed: " << ::strerror(error);
+		}
+		case 0:
+			LOG(kInfo) << "Connection closed.";
+			socket_handler_.invalidate();
+			lines_.clear();
+			return lines_;
 		}
-		std::cerr << "Error: recv failed due to something other than blocking!"
-				<< std::endl;
-	}
-	case 0:
-		std::cerr << "Connection closed." << std::endl;
-		socket_handler_.invalidate();
-		return std::vector<std::string>();
-	}
 
-	received_buffer_ += buffer.c_str();
-	return CheckForMessage();
+		framer_.Commit(received_bytes);
+	}
 }
 
-std::vector<std::string> Client::ReceiveMessage() {
+const Client::Lines& Client::ReceiveMessage() {
 	auto messages = CheckForMessage();
-	if (messages) {
-		return *messages;
+	while (!messages) {
+		// a message may arrive in several pieces
+		BlockUntilMessageArrives();
+		messages = CheckForMessage();
 	}
-	BlockUntilMessageArrives();
-	messages = CheckForMessage();
-	assert(messages && "Block released yet messages not ready");
 	return *messages;
 }
 
@@ -146,7 +181,7 @@ void Client::BlockUntilMessageArrives() {
 	auto rc = ::select(socket_handler_.get_handler() + 1,
 			&fds, nullptr, nullptr, nullptr);
 	if (rc == EINTR) {
-		std::cerr << "Interrupted system call" << std::endl;
+		LOG(kError) << "Interrupted system call";
 		assert(false && "I haven't figured out what to do heere");
 	}
 	assert(rc > 0 && "Nothing apart from EINTR should come");
@@ -159,82 +194,84 @@ void Client::BlockUntilMessageCanBeSent() {
 	auto rc = ::select(socket_handler_.get_handler() + 1,
 			nullptr, &fds, nullptr, nullptr);
 	if (rc == EINTR) {
-		std::cerr << "Interrupted system call" << std::endl;
+		LOG(kError) << "Interrupted system call";
 		assert(false && "I haven't figured out what to do heere");
 	}
 	assert(rc > 0 && "Nothing apart from EINTR should come");
 }
 
-void Client::Init(const std::vector<std::string>& info_lines, Solver& solver) {
+void Client::Init(const Lines& info_lines, Solver& solver) {
 	if (verbose_) {
-		std::cerr << "We got these field informations:" << std::endl;
+		LOG(kDebug) << "We got these field informations:";
 		for (auto& line : info_lines) {
-			std::cerr << line << std::endl;
+			LOG(kDebug) << line;
 		}
 	}
 
 	SaveInput(info_lines);
 
-	fieldInfo = parser_.ParseInit(info_lines);
+	fieldInfo = parser_.ParseInit(ToStrings(info_lines));
 	targets = fieldInfo.target_order;
+	state_.Reset();
 	solver.Init(fieldInfo.player);
+	solver.Precompute(fieldInfo, std::chrono::milliseconds{0});
 }
 
 State Client::Process(
-		const std::vector<std::string>& info_lines, Solver& solver) {
+		const Lines& info_lines, Solver& solver) {
 	SaveInput(info_lines);
 
-	if (!info_lines.empty() && info_lines[0].find("SCORE") == 0) {
-		auto after_info = parser_.ParseAfter(info_lines);
+	if (!info_lines.empty() && info_lines[0].starts_with("SCORE")) {
+		auto after_info = parser_.ParseAfter(ToStrings(info_lines));
 		(void)after_info;
 		return State::matchover;
 	}
-	auto info = parser_.ParseTurn(info_lines);
+	const auto& info = parser_.ParseTurn(info_lines);
 
 	if (info.tick == fieldInfo.max_tick - 1) {
-		std::cerr << "In last tick" << std::endl;
+		LOG(kInfo) << "In last tick";
 	}
 	if (info.end) {
-		std::cerr << "We got the end message: " << info_lines[0] << std::endl;
+		LOG(kInfo) << "We got the end message: " << info_lines[0];
 		solver.Shutdown();
 		return State::gameover;
 	}
 	if (verbose_) {
-		std::cerr << "We got these tick informations:" << std::endl;
+		LOG(kDebug) << "We got these tick informations:";
 		for (auto& line : info_lines) {
-			std::cerr << line << std::endl;
+			LOG(kDebug) << line;
 		}
 	}
-	grid_ = info.grid;
+	solver.Changed(state_.Update(info.grid, info.player));
+	const auto& grid = state_.Board();
 	opponent_ = info.opponent;
 
 	if (opponent_) {
-		solver.Update(grid_, info.player);
+		solver.Update(grid, info.player);
 	} else {
 		wait_ = true;
 		auto targetIt = std::find(targets.begin(), targets.end(), info.target);
 		assert(targetIt != targets.end());
 		++targetIt;
-		while (targetIt != targets.end() && !IsValid(grid_.Displays().at(*targetIt))) { ++targetIt; }
+		while (targetIt != targets.end() && !IsValid(grid.Displays().at(*targetIt))) { ++targetIt; }
 		int nextTarget = -1;
 		if (targetIt != targets.end()) {
 			nextTarget = *targetIt;
 		}
-		solver.Turn(grid_, info.player, info.target, info.extra, nextTarget,
+		solver.Turn(grid, info.player, info.target, info.extra, nextTarget,
 			[&](const Response& response) {
-				wait_ = false;
+				// may be called from the solver's thread
 				response_ = response;
+				wait_ = false;
+				loop_->Notify();
 			});
 	}
 	return State::ongoing;
 }
 
-void Client::SaveInput(const std::vector<std::string>& lines) {
-	if (output_.is_open()) {
-		for (const auto& line : lines) {
-			output_ << line << std::endl;
-		}
-		output_ << ".\n";
+void Client::SaveInput(const Lines& lines) {
+	if (log_) {
+		log_->Write(lines);
 	}
 }
 
@@ -245,13 +282,13 @@ std::vector<std::string> Client::FromResponse(const Response& response) const {
 	if (response.push.edge.x == -1) {
 		c = 0;
 		p = 1;
-	} else if (response.push.edge.x == grid_.Width()) {
+	} else if (response.push.edge.x == state_.Board().Width()) {
 		c = 0;
 		p = 0;
 	} else if (response.push.edge.y == -1) {
 		c = 1;
 		p = 1;
-	} else if (response.push.edge.y == grid_.Height()) {
+	} else if (response.push.edge.y == state_.Board().Height()) {
 		c = 1;
 		p = 0;
 	} else {
@@ -278,20 +315,19 @@ std::vector<std::string> Client::FromResponse(const Response& response) const {
 }
 
 bool Client::Run(Solver& solver) {
-	std::vector<std::string> msg = ReceiveMessage();
+	const auto& init = ReceiveMessage();
 
 	if (socket_handler_.valid()) {
-		Init(msg, solver);
+		Init(init, solver);
 	}
 
 
 	while (socket_handler_.valid()) {
-		bool firstUpdateReady = false;
-		boost::optional<std::vector<std::string>> input = CheckForMessage();
-		if (!input && firstUpdateReady) {
+		auto input = CheckForMessage();
+		if (!input) {
+			loop_->Wait();
 			solver.Idle();
-		} else if (input && socket_handler_.valid()) {
-			firstUpdateReady = true;
+		} else if (socket_handler_.valid()) {
 			auto state = Process(*input, solver);
 			if (state == State::matchover) {
 				return false;
@@ -305,19 +341,21 @@ bool Client::Run(Solver& solver) {
 			}
 
 			while (wait_) {
+				// the server doesn't talk during our turn
+				loop_->Wait(false);
 				solver.Idle();
 			}
 
 			if (socket_handler_.valid()) {
 				if (input) {
 					// response_ only set if we read something and processed it
-					msg = FromResponse(response_);
-					std::cout << "Sending response = " << response_ << std::endl;
+					auto msg = FromResponse(response_);
+					LOG(kInfo) << "Sending response = " << response_;
 					SendMessages(msg);
 				}
 			}
 		}
 	}
-	std::cerr << "Game over" << std::endl;
+	LOG(kInfo) << "Game over";
     return true;
 }
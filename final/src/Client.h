@@ -2,9 +2,14 @@
 #include "platform_dep.h"
 #include "Solver.h"
 #include "InputParser.h"
+#include "EventLoop.h"
+#include "MessageFramer.h"
+#include "GameState.h"
+#include "MatchLog.h"
+#include <atomic>
+#include <memory>
 #include <string>
 #include <sstream>
-#include <fstream>
 #include <vector>
 #include <boost/optional.hpp>
 
@@ -20,30 +25,35 @@ public:
 	bool Run(Solver& solver);
 
 private:
-	void Init(const std::vector<std::string>& field_infos, Solver& solver);
-	State Process(const std::vector<std::string>& tick_infos, Solver& solver);
+	using Lines = std::vector<boost::string_ref>;
+
+	void Init(const Lines& field_infos, Solver& solver);
+	State Process(const Lines& tick_infos, Solver& solver);
 
 	void SendMessages(const std::vector<std::string>& messages);
 	std::vector<std::string> FromResponse(const Response& response) const;
-	boost::optional<std::vector<std::string>> CheckForMessage();
-	std::vector<std::string> ReceiveMessage();
+	// The lines of the message stay valid until the next call
+	boost::optional<const Lines&> CheckForMessage();
+	const Lines& ReceiveMessage();
 
-	void SaveInput(const std::vector<std::string>& lines);
+	void SaveInput(const Lines& lines);
 	void BlockUntilMessageArrives();
 	void BlockUntilMessageCanBeSent();
 
 	platform_dep::tcp_socket socket_handler_;
-	std::string received_buffer_;
+	MessageFramer framer_;
+	Lines lines_;	// of the last message, pointing into framer_
+	std::unique_ptr<EventLoop> loop_;
 
 	InputParser parser_;
 
-	Grid grid_;
+	GameState state_;
 	FieldInfo fieldInfo;
 	int player_index_ = -1;
 	std::vector<int> targets;
-	bool wait_ = false;
+	std::atomic<bool> wait_{false};	// for our solver, set before response_
 	bool opponent_ = false;
 	bool verbose_ = false;
 	Response response_;
-	std::ofstream output_;
+	std::unique_ptr<MatchLogWriter> log_;
 };
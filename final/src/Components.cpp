@@ -0,0 +1,200 @@
+#include "Components.h"
+#include "FloodFill.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+void MarkTouchedLines(const Point& size, const Point& p, Field field,
+	char* cols, char* rows)
+{
+	cols[p.x] = 1;
+	rows[p.y] = 1;
+	if (IsWestOpen(field) && p.x > 0) {
+		cols[p.x - 1] = 1;
+	}
+	if (IsEastOpen(field) && p.x + 1 < size.x) {
+		cols[p.x + 1] = 1;
+	}
+	if (IsNorthOpen(field) && p.y > 0) {
+		rows[p.y - 1] = 1;
+	}
+	if (IsSouthOpen(field) && p.y + 1 < size.y) {
+		rows[p.y + 1] = 1;
+	}
+}
+
+} // namespace
+
+ComponentMap::ComponentMap(const Grid& grid, Arena* arena)
+	: size_(grid.Size())
+	, pushable_(arena)
+	, labels_(FullFloodFill(grid.Fields(), arena))
+	, sizes_(arena)
+	, cols_(arena)
+	, rows_(arena)
+{
+	pushable_.resize(size_.x + size_.y);
+	for (int x = 0; x < size_.x; ++x) {
+		pushable_[x] = !grid.IsBlockedX(x);
+	}
+	for (int y = 0; y < size_.y; ++y) {
+		pushable_[size_.x + y] = !grid.IsBlockedY(y);
+	}
+
+	int label_count = 0;
+	for (auto label : labels_.GetFields()) {
+		label_count = std::max(label_count, label);
+	}
+	sizes_.resize(label_count + 1, 0);
+	cols_.resize((label_count + 1) * size_.x, 0);
+	rows_.resize((label_count + 1) * size_.y, 0);
+
+	ForEachPoint(size_, [&](const Point& p) {
+		auto label = labels_.At(p);
+		++sizes_[label];
+		MarkTouchedLines(size_, p, grid.At(p),
+			&cols_[label * size_.x], &rows_[label * size_.y]);
+	});
+}
+
+int ComponentMap::Label(const Point& pos) const {
+	return labels_.At(pos);
+}
+
+int ComponentMap::Size(int label) const {
+	return sizes_[label];
+}
+
+bool ComponentMap::Touches(int label, const Point& edge) const {
+	if (edge.x == -1 || edge.x == size_.x) {
+		return Touches(label, size_.x + edge.y);
+	} else {
+		return Touches(label, edge.x);
+	}
+}
+
+int ComponentMap::LineCount() const {
+	return size_.x + size_.y;
+}
+
+bool ComponentMap::IsPushable(int line) const {
+	return pushable_[line];
+}
+
+bool ComponentMap::Touches(int label, int line) const {
+	if (line < size_.x) {
+		return cols_[label * size_.x + line];
+	} else {
+		return rows_[label * size_.y + line - size_.x];
+	}
+}
+
+bool ComponentMap::MayJoinWithPush(const Grid& grid, int from, const Point& to,
+	const Point& edge) const
+{
+	// Tiles keep their order along the pushed line, so apart from the
+	// inserted one (which may be rotated any way) we know how the shifted
+	// line connects to the unchanged cells next to it. Components are joined
+	// as a whole, so the result errs on the side of "might".
+	bool is_column = !(edge.x == -1 || edge.x == size_.x);
+	int length = is_column ? size_.y : size_.x;
+	int shift = (is_column ? edge.y == -1 : edge.x == -1) ? 1 : -1;
+	int inserted = shift == 1 ? 0 : length - 1;
+	Point along = is_column ? Point{0, 1} : Point{1, 0};
+	Point side = is_column ? Point{1, 0} : Point{0, 1};
+
+	auto cell = [&](int i) {
+		return is_column ? Point{edge.x, i} : Point{i, edge.y};
+	};
+	auto opens = [&](int i, const Point& direction) {
+		return i == inserted || IsOpenTowards(grid.At(cell(i - shift)), direction);
+	};
+	auto moved = [&](int i) {
+		return (i + shift + length) % length;
+	};
+
+	int label_count = sizes_.size();
+	ArenaVector<int> parent(label_count + length, 0, sizes_.get_allocator());
+	std::iota(parent.begin(), parent.end(), 0);
+	auto find = [&](int n) {
+		while (parent[n] != n) {
+			n = parent[n] = parent[parent[n]];
+		}
+		return n;
+	};
+	auto join = [&](int a, int b) {
+		parent[find(a)] = find(b);
+	};
+
+	for (int i = 0; i < length; ++i) {
+		auto pos = cell(i);
+		if (i + 1 < length &&
+			opens(i, along) && opens(i + 1, {-along.x, -along.y}))
+		{
+			join(label_count + i, label_count + i + 1);
+		}
+		for (auto dir : {side, Point{-side.x, -side.y}}) {
+			Point neighbor{pos.x + dir.x, pos.y + dir.y};
+			if (grid.IsInside(neighbor) && opens(i, dir) &&
+				IsOpenTowards(grid.At(neighbor), {-dir.x, -dir.y}))
+			{
+				join(label_count + i, labels_.At(neighbor));
+			}
+		}
+		// the moved cells of from are still reachable
+		if (labels_.At(pos) == from) {
+			join(label_count + moved(i), from);
+		}
+	}
+
+	auto on_line = is_column ? to.x == edge.x : to.y == edge.y;
+	auto to_node = on_line
+		? label_count + moved(is_column ? to.y : to.x)
+		: labels_.At(to);
+	return find(from) == find(to_node);
+}
+
+bool ComponentMap::MayJoinInTwoPushes(int from, int to) const {
+	// Each push joins at most the components touching its line, and two
+	// lines are joined if they cross, lie next to each other or touch the
+	// same component. Rows and columns always cross, so only parallel lines
+	// can be told apart here.
+	auto is_column = [&](int line) { return line < size_.x; };
+	int label_count = sizes_.size();
+
+	ArenaVector<int> from_lines(sizes_.get_allocator());
+	ArenaVector<int> to_lines(sizes_.get_allocator());
+	for (int line = 0; line < LineCount(); ++line) {
+		if (!IsPushable(line)) {
+			continue;
+		}
+		if (Touches(from, line)) {
+			from_lines.push_back(line);
+		}
+		if (Touches(to, line)) {
+			to_lines.push_back(line);
+		}
+	}
+
+	for (auto a : from_lines) {
+		for (auto b : to_lines) {
+			if (is_column(a) != is_column(b) || std::abs(a - b) <= 1) {
+				return true;
+			}
+			for (int label = 1; label < label_count; ++label) {
+				if (Touches(label, a) && Touches(label, b)) {
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+std::ostream& operator<<(std::ostream& os, const RelevanceStats& stats) {
+	os << stats.dropped << "/" << stats.pushes << " pushes dropped";
+	return os;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Point.h"
+#include "Matrix.h"
+#include "Grid.h"
+#include "Arena.h"
+
+#include <vector>
+
+// Connected components of a board, labelled with FullFloodFill.
+// Tiles off a pushed line keep their connections, so a push can only change
+// the components that lie on the pushed line or open towards it.
+class ComponentMap {
+public:
+	// arena, if given, must outlive the map
+	explicit ComponentMap(const Grid& grid, Arena* arena = nullptr);
+
+	int Label(const Point& pos) const;
+	int Size(int label) const;
+
+	// @return	true if pushing at edge can change the component of label
+	bool Touches(int label, const Point& edge) const;
+
+	// @return	false if pushing at edge can't make to reachable from the
+	//			component from, true if it might
+	bool MayJoinWithPush(const Grid& grid, int from, const Point& to,
+		const Point& edge) const;
+
+	// @return	false if no two pushes can join the two components,
+	//			true if they might
+	bool MayJoinInTwoPushes(int from, int to) const;
+
+private:
+	// Lines are indexed with columns first, then rows
+	int LineCount() const;
+	bool IsPushable(int line) const;
+	bool Touches(int label, int line) const;
+
+	Point size_;
+	ArenaVector<char> pushable_;
+	ArenaMatrix<int> labels_;
+	ArenaVector<int> sizes_;
+	ArenaVector<char> cols_;	// [label * width + x]
+	ArenaVector<char> rows_;	// [label * height + y]
+};
+
+struct RelevanceStats {
+	int pushes = 0;
+	int dropped = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, const RelevanceStats& stats);
@@ -0,0 +1,214 @@
+#include "DeadlineSolver.h"
+#include "UpwindSailer.h"
+#include "Util.h"
+#include "InputParser.h"
+#include "GameState.h"
+#include "Log.h"
+
+DeadlineSolver::DeadlineSolver(std::unique_ptr<Solver> solver,
+	std::chrono::milliseconds budget, std::shared_ptr<WorkPool> pool)
+	: solver_(std::move(solver))
+	, budget_(budget)
+	, pool_(pool ? std::move(pool) : std::make_shared<WorkPool>(1))
+	, watcher_([this] { Watch(); })
+{
+	solver_->SetProgress([this](const Response& response) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (running_turn_ == turn_ && answer_) {
+			partial_ = response;
+		}
+	});
+}
+
+DeadlineSolver::~DeadlineSolver() {
+	{
+		// the pool may outlive us, so wait for our tasks to leave it
+		std::unique_lock<std::mutex> lock(mutex_);
+		stop_ = true;
+		cancel_.Cancel();
+		turn_changed_.notify_all();
+		tasks_changed_.wait(lock, [&] { return submitted_.empty() && !running_; });
+	}
+	watcher_.join();
+}
+
+void DeadlineSolver::Init(int player) {
+	Post([this, player] { solver_->Init(player); });
+}
+
+void DeadlineSolver::Precompute(const FieldInfo& info,
+		std::chrono::milliseconds budget)
+{
+	Post([this, info, budget] { solver_->Precompute(info, budget); });
+}
+
+void DeadlineSolver::Changed(const TickChange& change) {
+	Post([this, change] { solver_->Changed(change); });
+}
+
+void DeadlineSolver::Shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		cancel_.Cancel();
+	}
+	Post([this] { solver_->Shutdown(); });
+}
+
+void DeadlineSolver::Update(const Grid& grid, int player) {
+	{
+		// the others have moved, so our last search is stale
+		std::lock_guard<std::mutex> lock(mutex_);
+		cancel_.Cancel();
+	}
+	Post([this, grid, player] { solver_->Update(grid, player); });
+}
+
+void DeadlineSolver::Turn(const Grid& grid, int player, int target,
+		Field field, int nextTarget, Callback fn)
+{
+	Response fallback;
+	if (budget_.count() > 0) {
+		fallback = FallbackResponse(grid, player, target, field);
+	}
+
+	int turn;
+	CancelToken cancel;
+	std::chrono::steady_clock::time_point deadline;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		turn = ++turn_;
+		cancel_.Cancel();
+		cancel_ = cancel;
+		answer_ = std::move(fn);
+		deadline_ = std::chrono::steady_clock::now() + budget_;
+		deadline = deadline_;
+		fallback_ = fallback;
+		partial_ = boost::none;
+	}
+	turn_changed_.notify_all();
+
+	Post([this, turn, cancel, deadline, grid, player, target, field,
+			nextTarget] {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (turn != turn_ || cancel.Cancelled()) {
+				// answered already, or a newer turn is waiting
+				return;
+			}
+			running_turn_ = turn;
+		}
+		solver_->SetCancel(cancel);
+		solver_->SetDeadline(deadline);
+		solver_->Turn(grid, player, target, field, nextTarget,
+			[this, turn, cancel](const Response& response) {
+				Answer(turn, response, cancel.Cancelled());
+			});
+	});
+}
+
+void DeadlineSolver::Answer(int turn, Response response, bool cancelled) {
+	Callback fn;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (turn != turn_ || !answer_) {
+			LOG(kDebug) << "Deadline: dropped the late response"
+				<< logging::Kv("turn", turn);
+			return;
+		}
+		if (cancelled && partial_) {
+			response = *partial_;
+		}
+		fn = std::move(answer_);
+		answer_ = nullptr;
+	}
+	turn_changed_.notify_all();
+	fn(response);
+}
+
+void DeadlineSolver::Post(std::function<void()> task) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	tasks_.push_back(std::move(task));
+	Schedule();
+}
+
+void DeadlineSolver::Schedule() {
+	// until a turn waits for an answer, there's no hurry
+	auto deadline = answer_ ? deadline_ : WorkPool::Clock::time_point::max();
+	if (running_ || (!submitted_.empty() && *submitted_.begin() <= deadline)) {
+		return;
+	}
+	// a more urgent call is submitted even if a lazy one is waiting already
+	submitted_.insert(deadline);
+	pool_->Submit(deadline, [this, deadline] { RunNext(deadline); });
+}
+
+void DeadlineSolver::RunNext(WorkPool::Clock::time_point deadline) {
+	std::function<void()> task;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		submitted_.erase(submitted_.find(deadline));
+		if (stop_ || running_ || tasks_.empty()) {
+			tasks_changed_.notify_all();
+			return;
+		}
+		task = std::move(tasks_.front());
+		tasks_.pop_front();
+		running_ = true;
+	}
+
+	task();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	running_ = false;
+	if (stop_) {
+		tasks_changed_.notify_all();
+	} else if (!tasks_.empty()) {
+		Schedule();
+	}
+}
+
+void DeadlineSolver::Watch() {
+	std::unique_lock<std::mutex> lock(mutex_);
+	for (;;) {
+		if (stop_) {
+			return;
+		}
+		if (!answer_ || budget_.count() <= 0) {
+			turn_changed_.wait(lock);
+			continue;
+		}
+		int turn = turn_;
+		if (turn_changed_.wait_until(lock, deadline_) ==
+				std::cv_status::no_timeout) {
+			continue;
+		}
+		if (turn != turn_ || !answer_) {
+			continue;
+		}
+		LOG(kInfo) << "Deadline: answering from "
+			<< (partial_ ? "the best partial result" : "UpwindSailerStep");
+		auto response = partial_ ? *partial_ : fallback_;
+		cancel_.Cancel();
+		lock.unlock();
+		Answer(turn, response, false);
+		lock.lock();
+	}
+}
+
+Response FallbackResponse(const Grid& grid, int player, int target, Field field) {
+	try {
+		auto response = UpwindSailerStep(grid, player, target, field);
+		if (grid.CanPush(response.push.edge)) {
+			return response;
+		}
+	} catch (const char* error) {
+		LOG(kWarning) << "UpwindSailerStep failed: " << error;
+	}
+
+	Response response;
+	auto variations = GetPushVariations(grid, field);
+	assert(!variations.empty());
+	response.push.edge = variations.front().edge;
+	response.push.field = variations.front().tile;
+	return response;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "Solver.h"
+#include "WorkPool.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <boost/optional.hpp>
+
+// Runs another solver on a WorkPool, so that Turn returns at once and the
+// response comes through the callback, from another thread. Its tasks are
+// as urgent as the deadline of the turn waiting for an answer.
+// If a turn runs out of time it is answered with the best response the
+// solver has reported so far, or an UpwindSailerStep, and the search is
+// cancelled. A new tick also cancels the search of the previous turn.
+// Calls to the solver stay in order, one at a time.
+class DeadlineSolver : public Solver {
+public:
+	// @param budget	time from the start of a turn to the answer, zero if
+	//					there is no limit
+	// @param pool		shared with other solvers, a thread of its own if null
+	DeadlineSolver(std::unique_ptr<Solver> solver,
+		std::chrono::milliseconds budget,
+		std::shared_ptr<WorkPool> pool = nullptr);
+	~DeadlineSolver() override;
+
+	void Init(int player) override;
+	void Precompute(const FieldInfo& info,
+			std::chrono::milliseconds budget) override;
+	void Changed(const TickChange& change) override;
+	void Shutdown() override;
+	void Update(const Grid& grid, int player) override;
+	void Turn(const Grid& grid, int player, int target, Field field,
+			int nextTarget, Callback fn) override;
+	// The solvers do their work in Turn, so this isn't forwarded
+	void Idle() override {}
+
+private:
+	void Post(std::function<void()> task);
+	// Submits RunNext to the pool, with mutex_ held
+	void Schedule();
+	// Runs the next task, then submits itself again for the rest, so that
+	// more urgent solvers get a turn in between
+	void RunNext(WorkPool::Clock::time_point deadline);
+	void Watch();
+	// Answers turn with response, unless it has been answered already.
+	// The response of a cancelled search gives way to the partial one.
+	void Answer(int turn, Response response, bool cancelled);
+
+	std::unique_ptr<Solver> solver_;
+	std::chrono::milliseconds budget_;
+
+	std::mutex mutex_;
+	std::condition_variable tasks_changed_;
+	std::condition_variable turn_changed_;
+	std::deque<std::function<void()>> tasks_;
+	std::multiset<WorkPool::Clock::time_point> submitted_;	// RunNext calls
+	bool running_ = false;	// a task of the solver
+	bool stop_ = false;
+
+	int turn_ = 0;			// our latest turn
+	int running_turn_ = 0;	// the turn of the solver
+	Callback answer_;		// of turn_, until it is answered
+	std::chrono::steady_clock::time_point deadline_;
+	CancelToken cancel_;	// of turn_
+	Response fallback_;
+	boost::optional<Response> partial_;
+
+	std::shared_ptr<WorkPool> pool_;
+	std::thread watcher_;	// answers at the deadline
+};
+
+// @return	UpwindSailerStep if it is a valid response, a push at the first
+//			pushable edge otherwise
+Response FallbackResponse(const Grid& grid, int player, int target, Field field);
@@ -0,0 +1,102 @@
+#include "Distances.h"
+#include <algorithm>
+
+DistanceTable::DistanceTable(const Point& size,
+	const std::vector<Point>& blocked_fields, int penalty)
+	: size_(size)
+	, blocked_cols_(size.x)
+	, blocked_rows_(size.y)
+{
+	taxicab_.resize(size.x * size.y);
+	proximity_.resize(size.x * size.y);
+	converge_.resize(size.x * size.y);
+
+	for (const auto& pos : blocked_fields) {
+		blocked_cols_[pos.x] = 1;
+		blocked_rows_[pos.y] = 1;
+	}
+
+	for (int oy = 0; oy < size.y; ++oy) {
+		for (int ox = 0; ox < size.x; ++ox) {
+			auto dx = std::min(ox, size.x - ox);
+			auto dy = std::min(oy, size.y - oy);
+			auto over_edge = (ox > size.x - ox || oy > size.y - oy);
+			auto index = oy * size.x + ox;
+
+			taxicab_[index] = dx + dy;
+
+			auto proximity = dx + dy;
+			if (dx == 0) {
+				proximity += dy;
+			} else if (dy == 0) {
+				proximity += dx;
+			}
+			proximity_[index] = proximity;
+
+			bool neighbor =
+				(ox == 0 && (oy == 1 || oy == size.y - 1)) ||
+				(oy == 0 && (ox == 1 || ox == size.x - 1));
+			if (neighbor) {
+				converge_[index] = -1;
+				continue;
+			}
+			auto converge = dx + dy + 10;
+			if (over_edge) {
+				converge += 2;
+			}
+			if ((dx == 0 && dy > 1) || (dy == 0 && dx > 1)) {
+				converge += penalty;
+			}
+			converge_[index] = converge;
+		}
+	}
+}
+
+Matrix<int> DistanceTable::TaxicabTo(const Point& q) const {
+	Matrix<int> distances(size_.x, size_.y);
+	for (int y = 0; y < size_.y; ++y) {
+		const int* row = &taxicab_[std::abs(y - q.y) * size_.x];
+		for (int x = 0; x < size_.x; ++x) {
+			distances.At(x, y) = row[std::abs(x - q.x)];
+		}
+	}
+	return distances;
+}
+
+Matrix<int> DistanceTable::ConvergeTo(const Point& q, int weight,
+	int blocked_weight) const
+{
+	Matrix<int> distances(size_.x, size_.y);
+	for (int y = 0; y < size_.y; ++y) {
+		const int* row = &converge_[std::abs(y - q.y) * size_.x];
+		for (int x = 0; x < size_.x; ++x) {
+			auto dst = row[std::abs(x - q.x)];
+			dst = dst >= 0 ? dst : NeighborDistance({x, y}, q);
+			distances.At(x, y) = weight * dst +
+				blocked_weight * (blocked_cols_[x] + blocked_rows_[y]);
+		}
+	}
+	return distances;
+}
+
+int DistanceTable::NeighborDistance(const Point& p, const Point& q) const {
+	auto dst = 1;
+	if (p.x == q.x) {
+		// column
+		auto top_dst = std::min(p.y, q.y);
+		auto bottom_dst = size_.y - 1 - std::max(p.y, q.y);
+		dst += std::min(top_dst, bottom_dst);
+		if (top_dst == bottom_dst) {
+			dst += 1;
+		}
+	} else {
+		// row
+		auto left_dst = std::min(p.x, q.x);
+		auto right_dst = size_.x - 1 - std::max(p.x, q.x);
+		dst += std::min(left_dst, right_dst);
+		if (left_dst == right_dst) {
+			dst += 1;
+		}
+	}
+	return dst;
+}
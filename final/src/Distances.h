@@ -0,0 +1,61 @@
+#pragma once
+#include "Point.h"
+#include "Matrix.h"
+#include <vector>
+#include <cstdlib>
+
+// Torus distances of the heuristics, tabulated by the offset of the points,
+// and the blocked lines through each cell. They only depend on the map, so
+// one table serves a whole game.
+class DistanceTable {
+public:
+	DistanceTable() = default;
+	// penalty is added when the points are on the same line, not next to
+	// each other
+	explicit DistanceTable(const Point& size,
+		const std::vector<Point>& blocked_fields = {}, int penalty = 3);
+
+	const Point& Size() const { return size_; }
+
+	int Taxicab(const Point& p, const Point& q) const {
+		return taxicab_[Index(p, q)];
+	}
+
+	// Taxicab, doubling the distance along a line
+	int Proximity(const Point& p, const Point& q) const {
+		return proximity_[Index(p, q)];
+	}
+
+	// Taxicab, preferring neighbors that a push through both can join
+	int Converge(const Point& p, const Point& q) const {
+		auto dst = converge_[Index(p, q)];
+		return dst >= 0 ? dst : NeighborDistance(p, q);
+	}
+
+	// @return	Taxicab distances of every cell to q
+	Matrix<int> TaxicabTo(const Point& q) const;
+
+	// @return	blocked row and column through p
+	int BlockedLines(const Point& p) const {
+		return blocked_cols_[p.x] + blocked_rows_[p.y];
+	}
+
+	// @return	weight times the Converge distance of every cell to q, plus
+	//			blocked_weight times its BlockedLines
+	Matrix<int> ConvergeTo(const Point& q, int weight = 1,
+		int blocked_weight = 0) const;
+
+private:
+	int Index(const Point& p, const Point& q) const {
+		return std::abs(p.y - q.y) * size_.x + std::abs(p.x - q.x);
+	}
+
+	int NeighborDistance(const Point& p, const Point& q) const;
+
+	Point size_{0, 0};
+	std::vector<int> taxicab_;
+	std::vector<int> proximity_;
+	std::vector<int> converge_;	// -1 for neighbors, see NeighborDistance
+	std::vector<int> blocked_cols_;
+	std::vector<int> blocked_rows_;
+};
@@ -1,13 +1,24 @@
 #include "EagerTaxicab.h"
 #include "Util.h"
 #include "FloodFill.h"
+#include "Components.h"
 #include "UpwindSailer.h"
+#include "InputParser.h"
+#include "Log.h"
 #include <limits>
 
+void EagerTaxicab::Precompute(const FieldInfo& info,
+		std::chrono::milliseconds budget)
+{
+	distances_ = DistanceTable{{info.width, info.height}};
+}
 
 void EagerTaxicab::Turn(const Grid& grid, int player, int target, Field field,
 		int nextTarget, Callback fn) {
 	grid_ = grid;
+	if (distances_.Size() != grid.Size()) {
+		distances_ = DistanceTable{grid.Size()};
+	}
 	player_ = player;
 	target_ = target;
 	extra_ = field;
@@ -16,12 +27,33 @@ void EagerTaxicab::Turn(const Grid& grid, int player, int target, Field field,
 
 Response EagerTaxicab::GetResponse() {
 	int best_distance = std::numeric_limits<int>::max();
-	int current_distance = TaxicabDistance(
-		grid_.Displays()[target_], grid_.Positions()[player_], grid_.Size());
+	int current_distance = distances_.Taxicab(
+		grid_.Displays()[target_], grid_.Positions()[player_]);
 
 	Response best_response{};
 
+	// Pushes that change neither the player's component nor the target's
+	// position all end up at the same distance, so one of them is enough
+	ComponentMap components(grid_);
+	auto player_label = components.Label(grid_.Positions()[player_]);
+	auto display_pos = grid_.Displays()[target_];
+	bool unchanged_evaluated = false;
+	RelevanceStats stats;
+
 	for (auto& variation : GetPushVariations(grid_, extra_)) {
+		auto& edge = variation.edge;
+		bool on_target_line = (edge.y == -1 || edge.y == grid_.Height())
+			? edge.x == display_pos.x
+			: edge.y == display_pos.y;
+		++stats.pushes;
+		if (!on_target_line && !components.Touches(player_label, edge)) {
+			if (unchanged_evaluated) {
+				++stats.dropped;
+				continue;
+			}
+			unchanged_evaluated = true;
+		}
+
 		Field new_extra = grid_.Push(variation.edge, variation.tile);
 
 		int distance;
@@ -36,6 +68,7 @@ Response EagerTaxicab::GetResponse() {
 
 		grid_.Push(variation.opposite_edge, new_extra);
 	}
+	LOG(kDebug) << "Relevance: " << stats;
 
 	if (best_distance < current_distance) {
 		return best_response;
@@ -47,16 +80,15 @@ Response EagerTaxicab::GetResponse() {
 std::tuple<int, Point> EagerTaxicab::MoveClosestToTarget() {
 	auto player_pos = grid_.Positions()[player_];
 	auto target_pos = grid_.Displays()[target_];
-	auto size = grid_.Size();
 	auto flood_fill = FloodFill(grid_.Fields(), player_pos);
 
-	int closest_distance = TaxicabDistance(target_pos, player_pos, size);
+	int closest_distance = distances_.Taxicab(target_pos, player_pos);
 	Point closest_target; // skip move
 
 	// dumb iteration
 	for (int x = 0; x < grid_.Width(); ++x) {
 		for (int y = 0; y < grid_.Height(); ++y) {
-			int distance = TaxicabDistance(target_pos, {x, y}, size);
+			int distance = distances_.Taxicab(target_pos, {x, y});
 			if (flood_fill.At(x, y) && distance < closest_distance) {
 				closest_distance = distance;
 				closest_target = {x, y};
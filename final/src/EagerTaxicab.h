@@ -1,9 +1,12 @@
 #pragma once
 #include "Solver.h"
+#include "Distances.h"
 
 class EagerTaxicab : public Solver {
 public:
 	void Init(int player) override {}
+	void Precompute(const FieldInfo& info,
+			std::chrono::milliseconds budget) override;
 	void Shutdown() override {}
 	void Update(const Grid& grid, int player) override {}
 	void Turn(const Grid& grid, int player, int target, Field field,
@@ -17,6 +20,7 @@ private:
 	std::tuple<int, Point> MoveClosestToTarget();
 
 	Grid grid_;
+	DistanceTable distances_;
 	Field extra_;
 	int player_ = -1;
 	int target_ = -1;
@@ -0,0 +1,94 @@
+#pragma once
+
+// Compile-time composable scoring of SuperFill's phases. An evaluator is a
+// type with a static Score(const Features&), so the search loops inline it.
+
+// What the phases know about a candidate position
+struct Features {
+	int displays = 0;		// reachable displays
+	int cells = 0;			// reachable cells
+	int next_target = 0;	// 1 if the next target is reachable
+	int distance = 0;		// to the target
+	int good_pushes = 0;	// second pushes reaching the target
+	int stays = 0;			// 1 if the player doesn't move
+	int blocked_lines = 0;	// blocked row and column through the position
+};
+
+template<int Features::*Member, int Weight>
+struct Term {
+	static constexpr int Score(const Features& f) { return Weight * (f.*Member); }
+};
+
+template<int Value>
+struct Constant {
+	static constexpr int Score(const Features&) { return Value; }
+};
+
+template<typename... Terms>
+struct Sum;
+
+template<>
+struct Sum<> {
+	static constexpr int Score(const Features&) { return 0; }
+};
+
+template<typename T, typename... Rest>
+struct Sum<T, Rest...> {
+	static constexpr int Score(const Features& f) {
+		return T::Score(f) + Sum<Rest...>::Score(f);
+	}
+};
+
+template<int Weight> using Displays = Term<&Features::displays, Weight>;
+template<int Weight> using Cells = Term<&Features::cells, Weight>;
+template<int Weight> using NextTarget = Term<&Features::next_target, Weight>;
+template<int Weight> using Distance = Term<&Features::distance, Weight>;
+template<int Weight> using GoodPushes = Term<&Features::good_pushes, Weight>;
+template<int Weight> using Stays = Term<&Features::stays, Weight>;
+template<int Weight> using BlockedLines = Term<&Features::blocked_lines, Weight>;
+
+// Area scores the area after SingleMove's second push. SingleMove prunes with
+// upper bounds of its features, so it must not decrease in any of them.
+// Approach scores the position DoubleMove moves to, unless ByArea is set, in
+// which case Area scores the target's area after the second push.
+// Converge scores the positions of ConvergeMove.
+template<typename AreaEval, typename ApproachEval, typename ConvergeEval,
+	bool ByArea = false>
+struct Evaluation {
+	using Area = AreaEval;
+	using Approach = ApproachEval;
+	using Converge = ConvergeEval;
+	static constexpr bool double_move_by_area = ByArea;
+};
+
+namespace evaluators {
+
+constexpr Features Unit(int Features::*member) {
+	Features f;
+	f.*member = 1;
+	return f;
+}
+
+template<typename Eval>
+constexpr bool IsMonotone() {
+	return Eval::Score(Unit(&Features::displays)) >= Eval::Score({}) &&
+		Eval::Score(Unit(&Features::cells)) >= Eval::Score({}) &&
+		Eval::Score(Unit(&Features::next_target)) >= Eval::Score({});
+}
+
+} // namespace evaluators
+
+using DefaultArea = Sum<Displays<1>, Cells<1>, NextTarget<10>>;
+using DefaultApproach = Sum<Constant<40>, Distance<-1>, GoodPushes<5>>;
+using DefaultConverge = Sum<Distance<-4>, Stays<-1>, BlockedLines<1>>;
+
+using DefaultEvaluation =
+	Evaluation<DefaultArea, DefaultApproach, DefaultConverge>;
+
+// DoubleMove prefers the second pushes opening the most around the target
+using AreaEvaluation =
+	Evaluation<DefaultArea, DefaultApproach, DefaultConverge, true>;
+
+// ConvergeMove prefers cells on blocked lines, which no push can move
+using BlockedEvaluation = Evaluation<DefaultArea, DefaultApproach,
+	Sum<Distance<-4>, Stays<-1>, BlockedLines<4>>>;
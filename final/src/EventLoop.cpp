@@ -0,0 +1,75 @@
+#include "EventLoop.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+EventLoop::EventLoop(int socket) : socket_(socket) {
+	epoll_ = ::epoll_create1(EPOLL_CLOEXEC);
+	event_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (epoll_ < 0 || event_ < 0) {
+		auto error = errno;
+		if (epoll_ >= 0) {
+			::close(epoll_);
+		}
+		throw std::runtime_error(
+			"Error: Cannot create event loop, error code: " +
+			std::to_string(error));
+	}
+
+	::epoll_event ev{};
+	ev.events = EPOLLIN;
+	ev.data.fd = event_;
+	::epoll_ctl(epoll_, EPOLL_CTL_ADD, event_, &ev);
+	ev.data.fd = socket_;
+	::epoll_ctl(epoll_, EPOLL_CTL_ADD, socket_, &ev);
+	watching_socket_ = true;
+}
+
+EventLoop::~EventLoop() {
+	::close(event_);
+	::close(epoll_);
+}
+
+void EventLoop::Notify() {
+	std::uint64_t one = 1;
+	auto rc = ::write(event_, &one, sizeof(one));
+	(void)rc;	// only fails if the counter would overflow
+}
+
+bool EventLoop::Wait(bool watch_socket) {
+	WatchSocket(watch_socket);
+
+	::epoll_event events[2];
+	int count;
+	do {
+		count = ::epoll_wait(epoll_, events, 2, -1);
+	} while (count < 0 && errno == EINTR);
+
+	bool notified = false;
+	for (int i = 0; i < count; ++i) {
+		if (events[i].data.fd == event_) {
+			std::uint64_t value;
+			auto rc = ::read(event_, &value, sizeof(value));
+			(void)rc;
+			notified = true;
+		}
+	}
+	return notified;
+}
+
+void EventLoop::WatchSocket(bool watch) {
+	if (watch == watching_socket_) {
+		return;
+	}
+	// removed rather than modified, as epoll reports hang ups and errors
+	// even without events
+	::epoll_event ev{};
+	ev.events = watch ? uint32_t(EPOLLIN) : 0u;
+	ev.data.fd = socket_;
+	::epoll_ctl(epoll_, watch ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, socket_, &ev);
+	watching_socket_ = watch;
+}
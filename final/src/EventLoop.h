@@ -0,0 +1,28 @@
+#pragma once
+
+// Sleeps until a socket is readable or another thread calls Notify, so the
+// client can wait for both the server and the solver without polling.
+class EventLoop {
+public:
+	explicit EventLoop(int socket);
+	~EventLoop();
+
+	EventLoop(const EventLoop&) = delete;
+	EventLoop& operator=(const EventLoop&) = delete;
+
+	// May be called from any thread. A Notify before Wait isn't lost.
+	void Notify();
+
+	// Blocks until Notify is called, or the socket is readable if
+	// watch_socket is set
+	// @return	true if it was notified
+	bool Wait(bool watch_socket = true);
+
+private:
+	void WatchSocket(bool watch);
+
+	int socket_;
+	int epoll_ = -1;
+	int event_ = -1;
+	bool watching_socket_ = false;
+};
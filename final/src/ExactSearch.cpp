@@ -0,0 +1,207 @@
+#include "ExactSearch.h"
+#include "Util.h"
+#include "Log.h"
+
+#include <string>
+#include <unordered_set>
+
+namespace {
+
+const unsigned char kUnreachable = 0xff;
+
+struct State {
+	Matrix<Field> fields;
+	Matrix<unsigned char> origins;	// our first move leading to each tile
+	Field extra;
+	Point target;
+	int first_push = -1;
+};
+
+std::string Key(const State& state) {
+	const auto& fields = state.fields.GetFields();
+	const auto& origins = state.origins.GetFields();
+	std::string key;
+	key.reserve(2 * fields.size() + 3);
+	for (int i = 0, ie = fields.size(); i < ie; ++i) {
+		key.push_back(char(fields[i] | (origins[i] != kUnreachable) << 4));
+	}
+	key.push_back(char(state.extra));
+	key.push_back(char(state.target.x));
+	key.push_back(char(state.target.y));
+	return key;
+}
+
+void ShiftTarget(const Point& edge, const Point& size, Point& target) {
+	if (edge.x == -1 && target.y == edge.y) {
+		target.x = (target.x + 1) % size.x;
+	} else if (edge.x == size.x && target.y == edge.y) {
+		target.x = (target.x + size.x - 1) % size.x;
+	} else if (edge.y == -1 && target.x == edge.x) {
+		target.y = (target.y + 1) % size.y;
+	} else if (edge.y == size.y && target.x == edge.x) {
+		target.y = (target.y + size.y - 1) % size.y;
+	}
+}
+
+// Spreads the origins of the tiles already reached over their components
+void Flood(const Matrix<Field>& fields, Matrix<unsigned char>& origins) {
+	auto width = fields.Width();
+	auto height = fields.Height();
+	std::vector<Point> stack;
+	ForEachPoint({width, height}, [&](const Point& p) {
+		if (origins.At(p) != kUnreachable) {
+			stack.push_back(p);
+		}
+	});
+
+	while (!stack.empty()) {
+		auto p = stack.back();
+		stack.pop_back();
+		auto origin = origins.At(p);
+		auto field = fields.At(p);
+		auto visit = [&](int x, int y) {
+			if (origins.At(x, y) == kUnreachable) {
+				origins.At(x, y) = origin;
+				stack.push_back({x, y});
+			}
+		};
+
+		if (p.x + 1 < width && IsEastOpen(field) &&
+			IsWestOpen(fields.At(p.x + 1, p.y)))
+		{
+			visit(p.x + 1, p.y);
+		}
+		if (p.x - 1 >= 0 && IsWestOpen(field) &&
+			IsEastOpen(fields.At(p.x - 1, p.y)))
+		{
+			visit(p.x - 1, p.y);
+		}
+		if (p.y + 1 < height && IsSouthOpen(field) &&
+			IsNorthOpen(fields.At(p.x, p.y + 1)))
+		{
+			visit(p.x, p.y + 1);
+		}
+		if (p.y - 1 >= 0 && IsNorthOpen(field) &&
+			IsSouthOpen(fields.At(p.x, p.y - 1)))
+		{
+			visit(p.x, p.y - 1);
+		}
+	}
+}
+
+} // namespace
+
+
+boost::optional<Response> ExactSearch(const Grid& grid, int player, int target,
+	Field extra, const ExactSearchLimits& limits, int* turns)
+{
+	auto size = grid.Size();
+	if (size.x * size.y > kUnreachable) {
+		return boost::none;
+	}
+
+	auto first_pushes = GetPushVariations(grid, extra);
+	std::vector<State> level;
+	std::unordered_set<std::string> visited;
+
+	// Our first move is free, later ones just spread over the components
+	for (int i = 0, ie = first_pushes.size(); i < ie; ++i) {
+		const auto& v = first_pushes[i];
+		State state;
+		state.fields = grid.Fields();
+		state.origins = Matrix<unsigned char>(size.x, size.y, kUnreachable);
+		state.extra = state.fields.Push(v.edge, v.tile);
+		state.target = grid.Displays()[target];
+		state.first_push = i;
+
+		auto pos = grid.Positions()[player];
+		ShiftTarget(v.edge, size, pos);
+		ShiftTarget(v.edge, size, state.target);
+		state.origins.At(pos) = kUnreachable - 1;
+		Flood(state.fields, state.origins);
+		ForEachPoint(size, [&](const Point& p) {
+			if (state.origins.At(p) != kUnreachable) {
+				state.origins.At(p) = p.x + p.y * size.x;
+			}
+		});
+
+		if (visited.insert(Key(state)).second) {
+			level.push_back(std::move(state));
+		}
+	}
+
+	for (int turn = 1; turn <= limits.max_turns && !level.empty(); ++turn) {
+		for (const auto& state : level) {
+			auto origin = state.origins.At(state.target);
+			if (origin == kUnreachable) {
+				continue;
+			}
+			const auto& v = first_pushes[state.first_push];
+			Point move{origin % size.x, origin / size.x};
+			auto pushed_pos = grid.Positions()[player];
+			ShiftTarget(v.edge, size, pushed_pos);
+			if (turns) {
+				*turns = turn;
+			}
+			return Response{{v.edge, v.tile},
+				move == pushed_pos ? Point{} : move};
+		}
+
+		std::vector<State> next_level;
+		for (const auto& state : level) {
+			if (limits.cancel.Cancelled()) {
+				LOG(kDebug) << "Exact search: cancelled";
+				return boost::none;
+			}
+			for (const auto& v : GetPushVariations(grid, state.extra)) {
+				if (int(visited.size()) >= limits.max_states) {
+					LOG(kDebug) << "Exact search: gave up"
+						<< logging::Kv("states", visited.size());
+					return boost::none;
+				}
+
+				State next;
+				next.fields = state.fields;
+				next.origins = state.origins;
+				next.extra = next.fields.Push(v.edge, v.tile);
+				next.origins.Rotate(v.edge);
+				next.target = state.target;
+				next.first_push = state.first_push;
+				ShiftTarget(v.edge, size, next.target);
+				Flood(next.fields, next.origins);
+
+				if (visited.insert(Key(next)).second) {
+					next_level.push_back(std::move(next));
+				}
+			}
+		}
+		level = std::move(next_level);
+	}
+	return boost::none;
+}
+
+bool UseExactSearch(const Grid& grid, const ExactSearchLimits& limits) {
+	const int small_board = 64;
+	const int endgame_displays = 3;
+
+	auto size = grid.Size();
+	auto cells = size.x * size.y;
+	if (cells > kUnreachable) {
+		return false;
+	}
+	if (cells <= small_board) {
+		return true;
+	}
+
+	// Two turns need about as many states as pushes squared
+	int pushes = 0;
+	for (int x = 0; x < size.x; ++x) {
+		pushes += !grid.IsBlockedX(x);
+	}
+	for (int y = 0; y < size.y; ++y) {
+		pushes += !grid.IsBlockedY(y);
+	}
+	pushes *= 2 * 4;
+	return grid.ActiveDisplayCount() <= endgame_displays &&
+		pushes * pushes <= limits.max_states;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "Grid.h"
+#include "Response.h"
+#include "CancelToken.h"
+
+#include <boost/optional.hpp>
+
+struct ExactSearchLimits {
+	int max_states = 1 << 15;
+	int max_turns = 8;
+	CancelToken cancel;
+};
+
+// Breadth first search over (tiles, extra tile, reachable area), assuming
+// the other players don't push in the meantime.
+// @return	the first step of a shortest way to the target, if one was found
+//			within the limits
+boost::optional<Response> ExactSearch(const Grid& grid, int player, int target,
+	Field extra, const ExactSearchLimits& limits = {}, int* turns = nullptr);
+
+// @return	true if the search space is small enough for ExactSearch, either
+//			because the board is small or only a few displays are left
+bool UseExactSearch(const Grid& grid, const ExactSearchLimits& limits = {});
@@ -5,6 +5,7 @@
 #include <chrono>
 
 #include "Util.h"
+#include "Log.h"
 
 namespace {
 
@@ -17,40 +18,11 @@ void MergeMatrices(Matrix<int>& base, const Matrix<int>& other, F fn) {
 	}
 }
 
-
-} // namespace
-
-Matrix<int> FloodFill(
-	const Matrix<Field>& fields,
-	const Point& origin)
-{
-	auto width = fields.Width();
-	auto height = fields.Height();
-
-	Matrix<int> reachable{width, height, 0};
-
-	FloodFillTo(reachable, fields, origin, 1);
-
-	return reachable;
-}
-
-void FloodFillTo(
-	Matrix<int>& fill_matrix,
-	const Matrix<Field>& fields,
-	const Point& origin,
+// Marks the area reachable from the points on stack, emptying it
+template<typename M, typename S>
+void FillFrom(M& fill_matrix, const Matrix<Field>& fields, S& stack,
 	int fill_value)
 {
-	std::vector<Point> origins(1, origin);
-	return FloodFillTo(fill_matrix, fields, origins, fill_value);
-}
-
-void FloodFillTo(
-	Matrix<int>& fill_matrix,
-	const Matrix<Field>& fields,
-	std::vector<Point> origins,
-	int fill_value)
-{
-	auto& stack = origins;
 	auto width = fields.Width();
 	auto height = fields.Height();
 
@@ -89,20 +61,120 @@ void FloodFillTo(
 	}
 }
 
-Matrix<int> FullFloodFill(const Matrix<Field>& fields, int start_index) {
-	auto width = fields.Width();
-	auto height = fields.Height();
-
-	Matrix<int> fill_map{width, height, 0};
-
+// Labels every component, reusing stack for all of them
+template<typename M, typename S>
+void FullFill(M& fill_map, const Matrix<Field>& fields, S& stack,
+	int start_index)
+{
 	int color = start_index;
 	for (int x = 0; x < fields.Width(); ++x) {
 		for (int y = 0; y < fields.Height(); ++y) {
 			if (fill_map.At(x, y) == 0) {
-				FloodFillTo(fill_map, fields, {x, y}, color++);
+				stack.push_back({x, y});
+				FillFrom(fill_map, fields, stack, color++);
 			}
 		}
 	}
+}
+
+// Reachability is symmetric, so players in the same component share its fill:
+// it is labeled by the first of them, then labels are turned into bitmasks
+template<typename M, typename S>
+void FillPlayers(M& fill_map, const Matrix<Field>& fields,
+	const std::vector<Point>& positions, S& stack)
+{
+	const int max_players = 31;
+	assert(positions.size() <= max_players);
+	int masks[max_players + 1] = {};
+
+	for (int i = 0, ie = positions.size(); i < ie; ++i) {
+		const auto& pos = positions[i];
+		if (pos.x < 0 || pos.y < 0) {
+			continue;
+		}
+		int label = fill_map.At(pos);
+		if (label == 0) {
+			label = i + 1;
+			stack.push_back(pos);
+			FillFrom(fill_map, fields, stack, label);
+		}
+		masks[label] |= 1 << i;
+	}
+
+	for (int y = 0; y < fill_map.Height(); ++y) {
+		for (int x = 0; x < fill_map.Width(); ++x) {
+			auto& cell = fill_map.At(x, y);
+			cell = masks[cell];
+		}
+	}
+}
+
+} // namespace
+
+Matrix<int> FloodFill(
+	const Matrix<Field>& fields,
+	const Point& origin)
+{
+	auto width = fields.Width();
+	auto height = fields.Height();
+
+	Matrix<int> reachable{width, height, 0};
+
+	FloodFillTo(reachable, fields, origin, 1);
+
+	return reachable;
+}
+
+void FloodFillTo(
+	Matrix<int>& fill_matrix,
+	const Matrix<Field>& fields,
+	const Point& origin,
+	int fill_value)
+{
+	std::vector<Point> origins(1, origin);
+	return FloodFillTo(fill_matrix, fields, origins, fill_value);
+}
+
+void FloodFillTo(
+	Matrix<int>& fill_matrix,
+	const Matrix<Field>& fields,
+	std::vector<Point> origins,
+	int fill_value)
+{
+	FillFrom(fill_matrix, fields, origins, fill_value);
+}
+
+Matrix<int> FullFloodFill(const Matrix<Field>& fields, int start_index) {
+	Matrix<int> fill_map{fields.Width(), fields.Height(), 0};
+	std::vector<Point> stack;
+	FullFill(fill_map, fields, stack, start_index);
+	return fill_map;
+}
+
+ArenaMatrix<int> FullFloodFill(const Matrix<Field>& fields, Arena* arena,
+	int start_index)
+{
+	ArenaMatrix<int> fill_map{fields.Width(), fields.Height(), 0, arena};
+	ArenaVector<Point> stack(arena);
+	FullFill(fill_map, fields, stack, start_index);
+	return fill_map;
+}
+
+Matrix<int> PlayersFloodFill(const Matrix<Field>& fields,
+	const std::vector<Point>& positions)
+{
+	Matrix<int> fill_map{fields.Width(), fields.Height(), 0};
+	std::vector<Point> stack;
+	FillPlayers(fill_map, fields, positions, stack);
+	return fill_map;
+}
+
+ArenaMatrix<int> PlayersFloodFill(const Matrix<Field>& fields,
+	const std::vector<Point>& positions, Arena* arena)
+{
+	ArenaMatrix<int> fill_map{fields.Width(), fields.Height(), 0, arena};
+	ArenaVector<Point> stack(arena);
+	FillPlayers(fill_map, fields, positions, stack);
 	return fill_map;
 }
 
@@ -186,10 +258,8 @@ Matrix<int> StupidFloodFill(Grid grid, const Point& origin, Field extra, bool mo
 	StupidFloodFillInternal(grid, extra, colors, pushes, 2, 3);
 	auto end_t = Clock::now();
 
-	std::cerr
-		<< "COLORING "
-		<< std::chrono::duration_cast<std::chrono::milliseconds>(end_t - start_t).count()
-		<< " ms" << (move_first ? " [move]" : " [push]") << std::endl;
+	LOG(kDebug) << "Coloring" << logging::Kv("mode", move_first ? "move" : "push")
+		<< logging::Kv("ms", Duration(end_t - start_t).count() * 1000);
 
 	return colors;
 }
@@ -3,6 +3,7 @@
 #include "Field.h"
 #include "Matrix.h"
 #include "Grid.h"
+#include "Arena.h"
 
 // will contain 1 where origin is reachable (0 otherwise)
 Matrix<int> FloodFill(
@@ -24,5 +25,17 @@ void FloodFillTo(
 
 // coordinates with the same integer value are reachable from each other
 Matrix<int> FullFloodFill(const Matrix<Field>& fields, int start_index = 1);
+// same, with memory from arena (or the heap if null)
+ArenaMatrix<int> FullFloodFill(const Matrix<Field>& fields, Arena* arena,
+	int start_index = 1);
+
+// bit i is set where player i can move to, in one fill for all players.
+// Players off the board, at (-1, -1), reach nothing.
+Matrix<int> PlayersFloodFill(const Matrix<Field>& fields,
+	const std::vector<Point>& positions);
+// same, with memory from arena (or the heap if null)
+ArenaMatrix<int> PlayersFloodFill(const Matrix<Field>& fields,
+	const std::vector<Point>& positions, Arena* arena);
+
 Matrix<int> StupidFloodFill(Grid grid, const Point& origin, Field extra, bool move_first);
 
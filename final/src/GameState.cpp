@@ -0,0 +1,49 @@
+#include "GameState.h"
+
+TickChange GameState::Update(const Grid& grid, int player) {
+	TickChange change;
+	change.player = player_;
+	if (valid_ && Matches(grid)) {
+		// the player didn't push, it may have run out of time
+		player_ = player;
+		return change;
+	}
+	if (valid_ && player_ >= 0) {
+		// the extra tile of the others isn't known
+		change.delta = grid.TryDiff(grid_, Field(0), player_);
+	}
+
+	if (change.delta) {
+		const auto& delta = *change.delta;
+		grid_.Push(delta.edge, delta.extra);
+		if (IsValid(delta.move)) {
+			grid_.UpdatePosition(player_, delta.move);
+		}
+		if (delta.scored) {
+			grid_.UpdateDisplay(delta.display, {-1, -1});
+		}
+		if (!Matches(grid)) {
+			change.delta = boost::none;
+		}
+	}
+	if (!change.delta) {
+		grid_ = grid;
+		change.rebuilt = true;
+	}
+
+	player_ = player;
+	valid_ = true;
+	return change;
+}
+
+void GameState::Reset() {
+	grid_ = {};
+	player_ = -1;
+	valid_ = false;
+}
+
+bool GameState::Matches(const Grid& grid) const {
+	return grid_.Fields().GetFields() == grid.Fields().GetFields() &&
+		grid_.Displays() == grid.Displays() &&
+		grid_.Positions() == grid.Positions();
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "Grid.h"
+#include <boost/optional.hpp>
+
+// What happened between two ticks
+struct TickChange {
+	int player = -1;		// who moved, -1 before the first tick
+	// The push, move and score of player, none if nothing changed
+	boost::optional<Grid::Delta> delta;
+	// The board had to be copied, so anything may have changed
+	bool rebuilt = false;
+};
+
+// The board of a game, kept from tick to tick: the change since the previous
+// tick is derived with Grid::TryDiff and applied in place. The board is only
+// copied from the tick if that doesn't reproduce it.
+class GameState {
+public:
+	// @param player	who is to move at grid
+	TickChange Update(const Grid& grid, int player);
+	void Reset();
+
+	const Grid& Board() const { return grid_; }
+
+private:
+	bool Matches(const Grid& grid) const;
+
+	Grid grid_;
+	int player_ = -1;	// to move at grid_
+	bool valid_ = false;
+};
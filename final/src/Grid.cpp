@@ -1,5 +1,6 @@
 #include "Grid.h"
 #include "Util.h"
+#include "Log.h"
 #include <cassert>
 #include <set>
 #include <algorithm>
@@ -183,6 +184,10 @@ void Grid::UpdateFields(std::vector<Field> fields) {
 	fields_.SetFields(std::move(fields));
 }
 
+void Grid::UpdateField(const Point& pos, Field field) {
+	fields_.At(pos) = field;
+}
+
 void Grid::UpdateDisplay(int index, const Point& pos) {
 	displays_[index] = pos;
 }
@@ -209,51 +214,28 @@ const std::vector<Point>& Grid::Positions() const {
 
 Field Grid::Push(const Point& pos, Field t) {
 	if (blocked_cols_.count(pos.x)) {
-		std::cerr << pos << " " << Size() << std::endl;
+		LOG(kError) << "Pushed invalid column" << logging::Kv("edge", pos)
+			<< logging::Kv("size", Size());
 		throw "Pushed invalid column";
 	} else if (blocked_rows_.count(pos.y)) {
-		std::cerr << pos << " " << Size() << std::endl;
+		LOG(kError) << "Pushed invalid row" << logging::Kv("edge", pos)
+			<< logging::Kv("size", Size());
 		throw "Pushed invalid row";
 	}
 
 	auto size = Size();
+	t = fields_.Push(pos, t);
 
 	if (pos.x == -1) {
-		assert(pos.y >= 0 && pos.y < size.y);
-		for (int x = size.x; x-- > 1; ) {
-			std::swap(fields_.At(x, pos.y), fields_.At(x - 1, pos.y));
-		}
-		std::swap(fields_.At(0, pos.y), t);
 		ShiftRow(size, pos, 1, positions_);
 		ShiftRow(size, pos, 1, displays_);
-	}
-
-	if (pos.x == size.x) {
-		assert(pos.y >= 0 && pos.y < size.y);
-		for (int x = 0; x < size.x - 1; ++x) {
-			std::swap(fields_.At(x, pos.y), fields_.At(x + 1, pos.y));
-		}
-		std::swap(fields_.At(size.x - 1, pos.y), t);
+	} else if (pos.x == size.x) {
 		ShiftRow(size, pos, -1, positions_);
 		ShiftRow(size, pos, -1, displays_);
-	}
-
-	if (pos.y == -1) {
-		assert(pos.x >= 0 && pos.x < size.x);
-		for (int y = size.y; y-- > 1; ) {
-			std::swap(fields_.At(pos.x, y), fields_.At(pos.x, y - 1));
-		}
-		std::swap(fields_.At(pos.x, 0), t);
+	} else if (pos.y == -1) {
 		ShiftCol(size, pos, 1, positions_);
 		ShiftCol(size, pos, 1, displays_);
-	}
-
-	if (pos.y == size.y) {
-		assert(pos.x >= 0 && pos.x < size.x);
-		for (int y = 0; y < size.y - 1; ++y) {
-			std::swap(fields_.At(pos.x, y), fields_.At(pos.x, y + 1));
-		}
-		std::swap(fields_.At(pos.x, size.y - 1), t);
+	} else if (pos.y == size.y) {
 		ShiftCol(size, pos, -1, positions_);
 		ShiftCol(size, pos, -1, displays_);
 	}
@@ -271,26 +253,45 @@ Field Grid::Push(int c, int p, int k, Field t) {
 }
 
 Grid::Delta Grid::Diff(const Grid& grid, Field extra, int player) const {
+	auto delta = TryDiff(grid, extra, player);
+	assert(delta && "Grids could not move to each other");
+	return delta ? *delta : Delta{};
+}
+
+boost::optional<Grid::Delta> Grid::TryDiff(const Grid& grid, Field extra,
+		int player) const
+{
 	auto size = Size();
+	if (grid.Size() != size) {
+		return boost::none;
+	}
+
 	std::vector<std::pair<Point, Field>> candidates;
+	bool any = extra == Field(0);
 	extra = Normalize(extra);
 	Field tile;
 
 	for (int x = 0; x < size.x; ++x) {
-		if (Normalize(tile = At(x, 0)) == extra) {
-			candidates.push_back({{x, -1}, tile});
+		if (IsBlockedX(x)) {
+			continue;
+		}
+		if (any || Normalize(tile = At(x, 0)) == extra) {
+			candidates.push_back({{x, -1}, At(x, 0)});
 		}
-		if (Normalize(tile = At(x, size.y - 1)) == extra) {
-			candidates.push_back({{x, size.y}, tile});
+		if (any || Normalize(tile = At(x, size.y - 1)) == extra) {
+			candidates.push_back({{x, size.y}, At(x, size.y - 1)});
 		}
 	}
 
 	for (int y = 0; y < size.y; ++y) {
-		if (Normalize(tile = At(0, y)) == extra) {
-			candidates.push_back({{-1, y}, tile});
+		if (IsBlockedY(y)) {
+			continue;
+		}
+		if (any || Normalize(tile = At(0, y)) == extra) {
+			candidates.push_back({{-1, y}, At(0, y)});
 		}
-		if (Normalize(tile = At(size.x - 1, y)) == extra) {
-			candidates.push_back({{size.x, y}, tile});
+		if (any || Normalize(tile = At(size.x - 1, y)) == extra) {
+			candidates.push_back({{size.x, y}, At(size.x - 1, y)});
 		}
 	}
 
@@ -306,7 +307,10 @@ Grid::Delta Grid::Diff(const Grid& grid, Field extra, int player) const {
 				auto dpos = displays_[i];
 				auto cpos = copy.displays_[i];
 				if (!IsValid(cpos)) {
-					assert(!IsValid(dpos));
+					if (IsValid(dpos)) {
+						mismatch = true;
+						break;
+					}
 					continue;
 				}
 				if (IsValid(dpos) && cpos != dpos) {
@@ -319,8 +323,7 @@ Grid::Delta Grid::Diff(const Grid& grid, Field extra, int player) const {
 				}
 			}
 
-			assert(disappeared <= 1);
-			if (mismatch) {
+			if (mismatch || disappeared > 1) {
 				continue;
 			}
 
@@ -336,14 +339,17 @@ Grid::Delta Grid::Diff(const Grid& grid, Field extra, int player) const {
 				continue;
 			}
 
-			if (last_disappeared >= 0) {
-				assert(positions_[player] == copy.displays_[last_disappeared]);
+			if (last_disappeared >= 0 &&
+				positions_[player] != copy.displays_[last_disappeared])
+			{
+				continue;
 			}
 
 			Delta delta;
 			delta.edge = cc.first;
 			delta.extra = cc.second;
 			delta.scored = disappeared > 0;
+			delta.display = last_disappeared;
 			if (moved == 1) {
 				delta.move = positions_[player];
 			}
@@ -351,8 +357,7 @@ Grid::Delta Grid::Diff(const Grid& grid, Field extra, int player) const {
 		}
 	}
 
-	assert(false && "Grids could not move to each other");
-	return {};
+	return boost::none;
 }
 
 Field Grid::TileDiff(const Grid& grid, Field extra) const {
@@ -422,6 +427,10 @@ bool Grid::IsBlockedY(int y) const {
 	return blocked_rows_.count(y);
 }
 
+const std::vector<Point>& Grid::BlockedFields() const {
+	return blocked_;
+}
+
 bool Grid::CanPush(const Point& pos) const {
 	auto size = Size();
 
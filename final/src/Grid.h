@@ -4,6 +4,7 @@
 #include <cstdlib>
 #include <cassert>
 #include <iostream>
+#include <boost/optional.hpp>
 
 #include "Point.h"
 #include "Matrix.h"
@@ -31,11 +32,13 @@ public:
 	void RandomizeBlocked(int n);
 	void ResetDisplays();
 	void UpdateFields(std::vector<Field> fields);
+	void UpdateField(const Point& pos, Field field);
 	void UpdateDisplay(int index, const Point& pos);
 	void UpdatePosition(int player, const Point& pos);
 	void AddBlocked(int x, int y);
 	bool IsBlockedX(int x) const;
 	bool IsBlockedY(int y) const;
+	const std::vector<Point>& BlockedFields() const;
 
 	Field At(int x, int y) const;
 	Field At(const Point& pos) const;
@@ -47,10 +50,15 @@ public:
 		Field extra = Field(0);
 		Point move;
 		bool scored = false;
+		int display = -1;	// the one scored
 	};
 
 	// @return 	the move that led from {grid, extra} to this.
 	Delta Diff(const Grid& grid, Field extra, int player) const;
+	// Same, with Field(0) as extra if it isn't known
+	// @return	none if no single move leads here
+	boost::optional<Delta> TryDiff(const Grid& grid, Field extra,
+			int player) const;
 
 	// @return	the tile that is missing after extra was pushed to grid
 	Field TileDiff(const Grid& grid, Field extra) const;
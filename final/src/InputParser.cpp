@@ -1,7 +1,57 @@
 #include "InputParser.h"
 #include "Point.h"
+#include "Log.h"
 #include <sstream>
 
+namespace {
+
+// Space separated words of a line, read without copying
+class Tokens {
+public:
+	explicit Tokens(boost::string_ref line) : rest_(line) {}
+
+	boost::string_ref Word() {
+		SkipSpaces();
+		std::size_t length = 0;
+		while (length < rest_.size() && rest_[length] != ' ') {
+			++length;
+		}
+		auto word = rest_.substr(0, length);
+		rest_.remove_prefix(length);
+		return word;
+	}
+
+	// @return	false if the next word isn't a number
+	bool Int(int& value) {
+		SkipSpaces();
+		bool negative = !rest_.empty() && rest_.front() == '-';
+		std::size_t i = negative ? 1 : 0;
+		if (i == rest_.size() || !IsDigit(rest_[i])) {
+			return false;
+		}
+		int result = 0;
+		for (; i < rest_.size() && IsDigit(rest_[i]); ++i) {
+			result = result * 10 + (rest_[i] - '0');
+		}
+		rest_.remove_prefix(i);
+		value = negative ? -result : result;
+		return true;
+	}
+
+private:
+	static bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+	void SkipSpaces() {
+		while (!rest_.empty() && (rest_.front() == ' ' || rest_.front() == '\r')) {
+			rest_.remove_prefix(1);
+		}
+	}
+
+	boost::string_ref rest_;
+};
+
+} // namespace
+
 InputParser::InputParser()
 	: extras_(kMaxPlayers, Field(15))
 	, scores_(kMaxPlayers, 0)
@@ -45,7 +95,7 @@ FieldInfo InputParser::ParseInit(const std::vector<std::string>& info_lines) {
 		} else if (command == "MAXTICK") {
 			ss >> info.max_tick;
 		} else {
-			std::cerr << "WARNING: unhandled command: " << command << std::endl;
+			LOG(kWarning) << "unhandled command: " << command;
 		}
 	}
 
@@ -55,64 +105,86 @@ FieldInfo InputParser::ParseInit(const std::vector<std::string>& info_lines) {
 	assert(info.max_tick > 0);
 	assert(info.player >= 0);
 	field_info_ = info;
+	turn_ = {};
+	prev_turn_ = {};
 	return info;
 }
 
 TurnInfo InputParser::ParseTurn(const std::vector<std::string>& info_lines) {
-	TurnInfo info;
+	std::vector<boost::string_ref> lines(info_lines.begin(), info_lines.end());
+	return ParseTurn(lines);
+}
+
+const TurnInfo& InputParser::ParseTurn(
+	const std::vector<boost::string_ref>& info_lines)
+{
+	auto& info = turn_;
+	info.end = false;
+	info.opponent = false;
+	info.score = false;
+	info.tick = -1;
+	info.player = -1;
+	info.target = -1;
+	info.extra = Field(0);
 
-	if (info_lines.size() == 1 && info_lines[0].find("END") == 0) {
+	if (info_lines.size() == 1 && info_lines[0].starts_with("END")) {
 		info.end = true;
 		return info;
 	}
 
-	if (!info_lines.empty() && info_lines[0].find("SCORE") == 0) {
+	if (!info_lines.empty() && info_lines[0].starts_with("SCORE")) {
 		info.score = true;
 		info.scores = prev_turn_.scores;
 		info.player = prev_turn_.player;
 		return info;
 	}
 
-	info.grid.Init(
-		field_info_.width, field_info_.height,
-		field_info_.displays, kMaxPlayers);
-
-	for (const auto& pos : field_info_.blocked_fields) {
-		info.grid.AddBlocked(pos.x, pos.y);
+	if (info.grid.Size() != Point{field_info_.width, field_info_.height}) {
+		info.grid = MapGrid(field_info_, kMaxPlayers);
+	} else {
+		info.grid.ResetDisplays();
+		for (int i = 0; i < kMaxPlayers; ++i) {
+			info.grid.UpdatePosition(i, {-1, -1});
+		}
 	}
 
 	for (auto& line : info_lines) {
-		std::stringstream ss(line);
-		std::string command;
-		ss >> command;
+		Tokens tokens(line);
+		auto command = tokens.Word();
 		if (command == "MESSAGE") {
 			if (line != "MESSAGE OK") {
-				std::cerr << line << std::endl;
+				LOG(kWarning) << line;
 			}
 		} else if (command == "TICK") {
-			ss >> info.tick;
+			tokens.Int(info.tick);
 		} else if (command == "FIELDS") {
-			std::vector<Field> fields(field_info_.width * field_info_.height);
-			for (Field& f : fields) {
-				ss >> f;
+			int width = field_info_.width;
+			int count = width * field_info_.height;
+			int f;
+			for (int i = 0; i < count && tokens.Int(f); ++i) {
+				info.grid.UpdateField({i % width, i / width}, Field(f));
 			}
-			info.grid.UpdateFields(std::move(fields));
 		} else if (command == "DISPLAY") {
 			int index;
 			Point p;
-			ss >> index >> p.x >> p.y;
-			info.grid.UpdateDisplay(index, p);
+			if (tokens.Int(index) && tokens.Int(p.x) && tokens.Int(p.y)) {
+				info.grid.UpdateDisplay(index, p);
+			}
 		} else if (command == "POSITION") {
 			int index;
 			Point p;
-			ss >> index >> p.x >> p.y;
-			info.grid.UpdatePosition(index, p);
+			if (tokens.Int(index) && tokens.Int(p.x) && tokens.Int(p.y)) {
+				info.grid.UpdatePosition(index, p);
+			}
 		} else if (command == "PLAYER") {
-			ss >> info.player;
+			tokens.Int(info.player);
 		} else if (command == "TARGET") {
-			ss >> info.target;
+			tokens.Int(info.target);
 		} else if (command == "EXTRAFIELD") {
-			ss >> info.extra;
+			int f;
+			if (tokens.Int(f)) {
+				info.extra = Field(f);
+			}
 		} else if (command == "GAMESCORE") {
 			// TODO if we need it at all
 		}
@@ -143,8 +215,9 @@ TurnInfo InputParser::ParseTurn(const std::vector<std::string>& info_lines) {
 	}
 	info.scores = scores_;
 #endif
-	prev_turn_ = info;
-	return info;
+	// turn_ keeps the older grid to parse the next turn into
+	std::swap(prev_turn_, turn_);
+	return prev_turn_;
 }
 
 
@@ -153,7 +226,7 @@ AfterInfo InputParser::ParseAfter(const std::vector<std::string>& lines) {
 	prev_turn_ = {};
 	field_info_ = {};
 	for (auto& line : lines) {
-		std::cerr << "PARSEAFTER : " << line << std::endl;
+		LOG(kDebug) << "PARSEAFTER : " << line;
 		std::stringstream ss(line);
 		std::string command;
 		ss >> command;
@@ -186,3 +259,12 @@ std::vector<std::string> InputParser::FromStream(std::istream& stream) {
 	}
 	return lines;
 }
+
+Grid MapGrid(const FieldInfo& info, int players) {
+	Grid grid;
+	grid.Init(info.width, info.height, info.displays, players);
+	for (const auto& pos : info.blocked_fields) {
+		grid.AddBlocked(pos.x, pos.y);
+	}
+	return grid;
+}
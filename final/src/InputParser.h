@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <boost/utility/string_ref.hpp>
 #include "Field.h"
 #include "Grid.h"
 
@@ -18,6 +19,10 @@ struct FieldInfo {
 };
 
 
+// @return	an empty board of the map, with its blocked tiles
+Grid MapGrid(const FieldInfo& info, int players);
+
+
 struct TurnInfo {
 	bool end = false;
 	bool opponent = false;
@@ -55,10 +60,15 @@ public:
 
 	FieldInfo ParseInit(const std::vector<std::string>& lines);
 	TurnInfo ParseTurn(const std::vector<std::string>& lines);
+	// Same, into a grid kept from two turns ago, so that after the first
+	// turns nothing is allocated.
+	// @return	valid until the next call
+	const TurnInfo& ParseTurn(const std::vector<boost::string_ref>& lines);
 	AfterInfo ParseAfter(const std::vector<std::string>& lines);
 
 private:
 	FieldInfo field_info_;
+	TurnInfo turn_;
 	TurnInfo prev_turn_;
 	std::vector<Field> extras_;
 	std::vector<int> scores_;
@@ -0,0 +1,148 @@
+#include "Log.h"
+#include "ByteQueue.h"
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace logging {
+
+std::atomic<int> g_level{int(Level::kTrace)};
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const Clock::time_point g_start = Clock::now();
+
+struct Header {
+	Level level;
+	Clock::rep time;
+};
+
+// Messages are copied into one queue. Threads take turns pushing with a
+// spin lock, which is only held for the copy.
+class Logger {
+public:
+	Logger() : queue_(1 << 20), worker_([this] { Work(); }) {}
+
+	~Logger() {
+		stop_ = true;
+		worker_.join();
+	}
+
+	void Push(Level level, Clock::time_point time, const std::string& text) {
+		thread_local std::string record;
+		Header header{level, (time - g_start).count()};
+		record.resize(sizeof(header) + text.size());
+		std::memcpy(&record[0], &header, sizeof(header));
+		std::memcpy(&record[sizeof(header)], text.data(), text.size());
+
+		while (lock_.test_and_set(std::memory_order_acquire)) {
+			std::this_thread::yield();
+		}
+		if (queue_.Push(record.data(), record.size())) {
+			++pushed_;
+		} else {
+			// never block the caller on the terminal
+			++dropped_;
+		}
+		lock_.clear(std::memory_order_release);
+	}
+
+	void Flush() {
+		auto pushed = pushed_.load();
+		while (written_ < pushed) {
+			std::this_thread::yield();
+		}
+	}
+
+private:
+	void Work() {
+		static const char kLevels[] = "TDIWE";
+		std::string record;
+		for (;;) {
+			bool stop = stop_;
+			if (!queue_.Pop(record)) {
+				if (auto dropped = dropped_.exchange(0)) {
+					std::fprintf(stderr, "log: dropped %d messages\n", dropped);
+				}
+				if (stop) {
+					break;
+				}
+				std::fflush(stderr);
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				continue;
+			}
+
+			Header header;
+			std::memcpy(&header, record.data(), sizeof(header));
+			double seconds = std::chrono::duration<double>(
+				Clock::duration(header.time)).count();
+			std::fprintf(stderr, "%10.6f %c %.*s\n", seconds,
+				kLevels[int(header.level)],
+				int(record.size() - sizeof(header)),
+				record.data() + sizeof(header));
+			if (header.level >= Level::kError) {
+				std::fflush(stderr);
+			}
+			++written_;
+		}
+		std::fflush(stderr);
+	}
+
+	ByteQueue queue_;
+	std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+	std::atomic<long> pushed_{0};
+	std::atomic<long> written_{0};
+	std::atomic<int> dropped_{0};
+	std::atomic<bool> stop_{false};
+	std::thread worker_;
+};
+
+Logger& GetLogger() {
+	static Logger logger;
+	return logger;
+}
+
+std::string& LineBuffer() {
+	thread_local std::string text;
+	return text;
+}
+
+} // namespace
+
+void SetLevel(Level level) {
+	g_level = int(level);
+}
+
+bool ParseLevel(const std::string& name, Level& level) {
+	const char* names[] = {"trace", "debug", "info", "warning", "error", "off"};
+	for (int i = 0; i <= int(Level::kOff); ++i) {
+		if (name == names[i]) {
+			level = Level(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+void Flush() {
+	GetLogger().Flush();
+}
+
+Line::Line(Level level)
+	: level_(level)
+	, time_(Clock::now())
+	, text_(LineBuffer())
+{
+	text_.clear();
+}
+
+Line::~Line() {
+	GetLogger().Push(level_, time_, text_);
+	if (level_ >= Level::kError) {
+		Flush();
+	}
+}
+
+} // namespace logging
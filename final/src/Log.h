@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <boost/utility/string_ref.hpp>
+
+// Levelled logging, written to stderr by a background thread, so that the
+// thread logging only formats its values and copies them into a queue.
+//
+//	LOG(kDebug) << "Single Move" << logging::Kv("pruned", pruned);
+//
+// Messages below LABYRINTH_LOG_LEVEL are compiled out, their values aren't
+// even evaluated. Those below the level set at runtime are skipped.
+
+#ifndef LABYRINTH_LOG_LEVEL
+#define LABYRINTH_LOG_LEVEL 0
+#endif
+
+namespace logging {
+
+enum class Level { kTrace, kDebug, kInfo, kWarning, kError, kOff };
+
+void SetLevel(Level level);
+
+// @return	false if name isn't trace, debug, info, warning, error or off
+bool ParseLevel(const std::string& name, Level& level);
+
+// Blocks until every message logged so far is written
+void Flush();
+
+extern std::atomic<int> g_level;
+
+constexpr bool Compiled(Level level) {
+	return int(level) >= LABYRINTH_LOG_LEVEL;
+}
+
+inline bool Enabled(Level level) {
+	return int(level) >= g_level.load(std::memory_order_relaxed);
+}
+
+// A value of a structured message, written as key=value
+template<typename T>
+struct KeyValue {
+	const char* key;
+	const T& value;
+};
+
+template<typename T>
+KeyValue<T> Kv(const char* key, const T& value) {
+	return {key, value};
+}
+
+// One message, queued when destroyed. Errors are written before it returns.
+class Line {
+public:
+	explicit Line(Level level);
+	~Line();
+
+	Line(const Line&) = delete;
+	Line& operator=(const Line&) = delete;
+
+	Line& operator<<(char c) {
+		text_ += c;
+		return *this;
+	}
+
+	Line& operator<<(const char* s) {
+		text_ += s;
+		return *this;
+	}
+
+	Line& operator<<(const std::string& s) {
+		text_ += s;
+		return *this;
+	}
+
+	Line& operator<<(boost::string_ref s) {
+		text_.append(s.data(), s.size());
+		return *this;
+	}
+
+	template<typename T>
+	typename std::enable_if<std::is_integral<T>::value, Line&>::type
+	operator<<(T value) {
+		text_ += std::to_string(value);
+		return *this;
+	}
+
+	template<typename T>
+	typename std::enable_if<!std::is_integral<T>::value, Line&>::type
+	operator<<(const T& value) {
+		std::ostringstream ss;
+		ss << value;
+		text_ += ss.str();
+		return *this;
+	}
+
+	template<typename T>
+	Line& operator<<(const KeyValue<T>& kv) {
+		text_ += ' ';
+		text_ += kv.key;
+		text_ += '=';
+		return *this << kv.value;
+	}
+
+private:
+	Level level_;
+	std::chrono::steady_clock::time_point time_;
+	std::string& text_;	// reused by the thread
+};
+
+} // namespace logging
+
+#define LOG(level) \
+	if (!::logging::Compiled(::logging::Level::level) || \
+		!::logging::Enabled(::logging::Level::level)) {} \
+	else ::logging::Line(::logging::Level::level)
@@ -0,0 +1,507 @@
+#include "MatchLog.h"
+#include "Log.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+const char kBinaryLogMagic[8] = {'L', 'A', 'B', 'Y', 'L', 'O', 'G', 1};
+
+namespace {
+
+const char kTextRecord = 'T';
+const char kTurnRecord = 'R';
+
+enum TurnFlags {
+	kMessageOk = 1,
+	kTarget = 2,
+	kExtraField = 4,
+	kGameScore = 8,
+};
+
+struct Turn {
+	int tick = -1;
+	int player = -1;
+	int flags = 0;
+	int target = -1;
+	int extra = -1;
+	int game_score = -1;
+	std::vector<int> fields;
+	std::vector<Point> displays;
+	std::vector<Point> positions;
+};
+
+void PutVarint(std::string& out, unsigned value) {
+	while (value >= 0x80) {
+		out.push_back(char((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(char(value));
+}
+
+bool GetVarint(std::istream& input, unsigned& value) {
+	value = 0;
+	for (int shift = 0; shift < 35; shift += 7) {
+		int c = input.get();
+		if (c == EOF) {
+			return false;
+		}
+		value |= unsigned(c & 0x7f) << shift;
+		if (!(c & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Numbers after the first word of line
+std::vector<int> Numbers(boost::string_ref line) {
+	std::vector<int> numbers;
+	auto space = line.find(' ');
+	if (space == boost::string_ref::npos) {
+		return numbers;
+	}
+	std::istringstream ss(line.substr(space + 1).to_string());
+	int x;
+	while (ss >> x) {
+		numbers.push_back(x);
+	}
+	return numbers;
+}
+
+std::string Join(const std::vector<boost::string_ref>& lines) {
+	std::string text;
+	for (const auto& line : lines) {
+		text.append(line.data(), line.size());
+		text += '\n';
+	}
+	return text;
+}
+
+// Init messages set the size of the board
+void ObserveText(const std::vector<boost::string_ref>& lines,
+	int& width, int& height, std::vector<Point>& displays,
+	std::vector<Point>& positions)
+{
+	for (const auto& line : lines) {
+		if (line.starts_with("SIZE ")) {
+			auto numbers = Numbers(line);
+			if (numbers.size() == 2) {
+				width = numbers[0];
+				height = numbers[1];
+			}
+			displays.clear();
+			positions.clear();
+		} else if (line.starts_with("DISPLAYS ")) {
+			auto numbers = Numbers(line);
+			if (numbers.size() == 1) {
+				displays.assign(numbers[0], {-1, -1});
+			}
+		}
+	}
+}
+
+void SetEntity(std::vector<Point>& entities, int index, const Point& pos) {
+	if (index < 0 || index > 1000) {
+		return;
+	}
+	if (int(entities.size()) <= index) {
+		entities.resize(index + 1, {-1, -1});
+	}
+	entities[index] = pos;
+}
+
+Turn ParseTurn(const std::vector<boost::string_ref>& lines, int displays) {
+	Turn turn;
+	turn.displays.assign(displays, {-1, -1});
+	for (const auto& line : lines) {
+		auto numbers = Numbers(line);
+		if (line.starts_with("TICK ") && numbers.size() == 1) {
+			turn.tick = numbers[0];
+		} else if (line.starts_with("FIELDS ")) {
+			turn.fields = numbers;
+		} else if (line.starts_with("DISPLAY ") && numbers.size() == 3) {
+			SetEntity(turn.displays, numbers[0], {numbers[1], numbers[2]});
+		} else if (line.starts_with("POSITION ") && numbers.size() == 3) {
+			SetEntity(turn.positions, numbers[0], {numbers[1], numbers[2]});
+		} else if (line.starts_with("PLAYER ") && numbers.size() == 1) {
+			turn.player = numbers[0];
+		} else if (line == "MESSAGE OK") {
+			turn.flags |= kMessageOk;
+		} else if (line.starts_with("TARGET ") && numbers.size() == 1) {
+			turn.flags |= kTarget;
+			turn.target = numbers[0];
+		} else if (line.starts_with("EXTRAFIELD ") && numbers.size() == 1) {
+			turn.flags |= kExtraField;
+			turn.extra = numbers[0];
+		} else if (line.starts_with("GAMESCORE ") && numbers.size() == 1) {
+			turn.flags |= kGameScore;
+			turn.game_score = numbers[0];
+		}
+	}
+	return turn;
+}
+
+// The lines the server sends for turn
+std::vector<std::string> RenderTurn(const Turn& turn) {
+	std::vector<std::string> lines;
+	lines.push_back("TICK " + std::to_string(turn.tick));
+	std::string fields = "FIELDS";
+	for (auto f : turn.fields) {
+		fields += ' ';
+		fields += std::to_string(f);
+	}
+	lines.push_back(std::move(fields));
+	for (int i = 0, ie = turn.displays.size(); i < ie; ++i) {
+		const auto& p = turn.displays[i];
+		if (IsValid(p)) {
+			lines.push_back("DISPLAY " + std::to_string(i) + " " +
+				std::to_string(p.x) + " " + std::to_string(p.y));
+		}
+	}
+	for (int i = 0, ie = turn.positions.size(); i < ie; ++i) {
+		const auto& p = turn.positions[i];
+		if (IsValid(p)) {
+			lines.push_back("POSITION " + std::to_string(i) + " " +
+				std::to_string(p.x) + " " + std::to_string(p.y));
+		}
+	}
+	lines.push_back("PLAYER " + std::to_string(turn.player));
+	if (turn.flags & kMessageOk) {
+		lines.push_back("MESSAGE OK");
+	}
+	if (turn.flags & kTarget) {
+		lines.push_back("TARGET " + std::to_string(turn.target));
+	}
+	if (turn.flags & kExtraField) {
+		lines.push_back("EXTRAFIELD " + std::to_string(turn.extra));
+	}
+	if (turn.flags & kGameScore) {
+		lines.push_back("GAMESCORE " + std::to_string(turn.game_score));
+	}
+	return lines;
+}
+
+// Coordinates are -1 or on the board, stored one higher
+void PutEntityChanges(std::string& out, const std::vector<Point>& previous,
+	const std::vector<Point>& current)
+{
+	std::vector<int> changed;
+	for (int i = 0, ie = current.size(); i < ie; ++i) {
+		if (i >= int(previous.size()) || !(previous[i] == current[i])) {
+			changed.push_back(i);
+		}
+	}
+	PutVarint(out, changed.size());
+	for (int i : changed) {
+		PutVarint(out, i);
+		PutVarint(out, current[i].x + 1);
+		PutVarint(out, current[i].y + 1);
+	}
+}
+
+bool GetEntityChanges(std::istream& input, std::vector<Point>& entities) {
+	unsigned count, index, x, y;
+	if (!GetVarint(input, count)) {
+		return false;
+	}
+	for (unsigned i = 0; i < count; ++i) {
+		if (!GetVarint(input, index) || !GetVarint(input, x) ||
+			!GetVarint(input, y) || index >= entities.size())
+		{
+			return false;
+		}
+		entities[index] = {int(x) - 1, int(y) - 1};
+	}
+	return true;
+}
+
+bool Encodable(const Point& p, int width, int height) {
+	return (p.x == -1 && p.y == -1) ||
+		(p.x >= 0 && p.y >= 0 && p.x < width && p.y < height);
+}
+
+} // namespace
+
+bool IsBinaryLogName(const std::string& filename) {
+	const std::string extension = ".bin";
+	return filename.size() >= extension.size() &&
+		filename.compare(filename.size() - extension.size(),
+			extension.size(), extension) == 0;
+}
+
+BinaryLogEncoder::BinaryLogEncoder(std::ostream& output) : output_(output) {
+	output_.write(kBinaryLogMagic, sizeof(kBinaryLogMagic));
+}
+
+void BinaryLogEncoder::Write(const std::vector<boost::string_ref>& lines) {
+	int cells = width_ * height_;
+	bool turn_like = width_ > 0 && height_ > 0 && !lines.empty() &&
+		lines.front().starts_with("TICK ");
+
+	if (turn_like) {
+		auto turn = ParseTurn(lines, displays_.size());
+		bool encodable = turn.tick >= 0 && turn.player >= 0 &&
+			int(turn.fields.size()) == cells &&
+			turn.displays.size() == displays_.size() &&
+			turn.positions.size() >= positions_.size();
+		for (auto f : turn.fields) {
+			encodable = encodable && f >= 0 && f < 16;
+		}
+		for (const auto& p : turn.displays) {
+			encodable = encodable && Encodable(p, width_, height_);
+		}
+		for (const auto& p : turn.positions) {
+			encodable = encodable && Encodable(p, width_, height_);
+		}
+		// anything the turn wouldn't be written back as goes as text
+		if (encodable) {
+			auto rendered = RenderTurn(turn);
+			encodable = rendered.size() == lines.size();
+			for (std::size_t i = 0; encodable && i < lines.size(); ++i) {
+				encodable = lines[i] == rendered[i];
+			}
+		}
+
+		if (encodable) {
+			record_.clear();
+			record_.push_back(kTurnRecord);
+			PutVarint(record_, turn.tick);
+			PutVarint(record_, turn.player);
+			record_.push_back(char(turn.flags));
+			if (turn.flags & kTarget) {
+				PutVarint(record_, turn.target);
+			}
+			if (turn.flags & kExtraField) {
+				PutVarint(record_, turn.extra);
+			}
+			if (turn.flags & kGameScore) {
+				PutVarint(record_, turn.game_score);
+			}
+			for (int i = 0; i < cells; i += 2) {
+				int high = i + 1 < cells ? turn.fields[i + 1] : 0;
+				record_.push_back(char(turn.fields[i] | high << 4));
+			}
+			PutEntityChanges(record_, displays_, turn.displays);
+			PutVarint(record_, turn.positions.size());
+			PutEntityChanges(record_, positions_, turn.positions);
+			output_.write(record_.data(), record_.size());
+
+			displays_ = std::move(turn.displays);
+			positions_ = std::move(turn.positions);
+			return;
+		}
+	}
+
+	ObserveText(lines, width_, height_, displays_, positions_);
+	text_ = Join(lines);
+	record_.clear();
+	record_.push_back(kTextRecord);
+	PutVarint(record_, text_.size());
+	output_.write(record_.data(), record_.size());
+	output_.write(text_.data(), text_.size());
+}
+
+MatchLogReader::MatchLogReader(std::istream& input) : input_(input) {
+	char magic[sizeof(kBinaryLogMagic)];
+	input_.read(magic, sizeof(magic));
+	if (input_.gcount() == sizeof(magic) &&
+		std::equal(magic, magic + sizeof(magic), kBinaryLogMagic))
+	{
+		binary_ = true;
+		return;
+	}
+	input_.clear();
+	input_.seekg(0);
+}
+
+std::vector<std::string> MatchLogReader::Next() {
+	std::vector<std::string> lines;
+	if (!binary_) {
+		std::string line;
+		while (std::getline(input_, line) && line != ".") {
+			lines.push_back(line);
+		}
+		return lines;
+	}
+
+	int kind = input_.get();
+	if (kind == kTurnRecord) {
+		if (!ReadTurn(lines)) {
+			std::cerr << "error: corrupt turn in binary log" << std::endl;
+			lines.clear();
+		}
+		return lines;
+	}
+	if (kind != kTextRecord) {
+		return lines;
+	}
+
+	unsigned size;
+	if (!GetVarint(input_, size)) {
+		return lines;
+	}
+	std::string text(size, '\0');
+	input_.read(&text[0], size);
+	std::istringstream ss(text);
+	std::string line;
+	while (std::getline(ss, line)) {
+		lines.push_back(line);
+	}
+
+	std::vector<boost::string_ref> refs(lines.begin(), lines.end());
+	ObserveText(refs, width_, height_, displays_, positions_);
+	return lines;
+}
+
+MatchLogReader::Position MatchLogReader::Tell() {
+	Position position;
+	position.offset = input_.tellg();
+	position.width = width_;
+	position.height = height_;
+	position.displays = displays_;
+	position.positions = positions_;
+	return position;
+}
+
+void MatchLogReader::Seek(const Position& position) {
+	input_.clear();
+	input_.seekg(position.offset);
+	width_ = position.width;
+	height_ = position.height;
+	displays_ = position.displays;
+	positions_ = position.positions;
+}
+
+bool MatchLogReader::ReadTurn(std::vector<std::string>& lines) {
+	Turn turn;
+	unsigned tick, player, value;
+	if (!GetVarint(input_, tick) || !GetVarint(input_, player)) {
+		return false;
+	}
+	turn.tick = tick;
+	turn.player = player;
+	turn.flags = input_.get();
+	if (turn.flags == EOF) {
+		return false;
+	}
+	if (turn.flags & kTarget) {
+		if (!GetVarint(input_, value)) {
+			return false;
+		}
+		turn.target = value;
+	}
+	if (turn.flags & kExtraField) {
+		if (!GetVarint(input_, value)) {
+			return false;
+		}
+		turn.extra = value;
+	}
+	if (turn.flags & kGameScore) {
+		if (!GetVarint(input_, value)) {
+			return false;
+		}
+		turn.game_score = value;
+	}
+
+	int cells = width_ * height_;
+	if (cells <= 0) {
+		return false;
+	}
+	turn.fields.resize(cells);
+	for (int i = 0; i < cells; i += 2) {
+		int c = input_.get();
+		if (c == EOF) {
+			return false;
+		}
+		turn.fields[i] = c & 15;
+		if (i + 1 < cells) {
+			turn.fields[i + 1] = c >> 4;
+		}
+	}
+
+	if (!GetEntityChanges(input_, displays_)) {
+		return false;
+	}
+	unsigned positions;
+	if (!GetVarint(input_, positions) || positions > 1000) {
+		return false;
+	}
+	positions_.resize(positions, {-1, -1});
+	if (!GetEntityChanges(input_, positions_)) {
+		return false;
+	}
+	turn.displays = displays_;
+	turn.positions = positions_;
+
+	lines = RenderTurn(turn);
+	return true;
+}
+
+MatchLogWriter::MatchLogWriter(const std::string& filename, bool binary)
+	: output_(filename, binary ? std::ios::binary : std::ios::out)
+	, binary_(binary)
+	, queue_(1 << 22)
+	, worker_([this] { Work(); })
+{
+	if (!output_) {
+		std::cerr << "error: cannot write log: " << filename << std::endl;
+	}
+}
+
+MatchLogWriter::~MatchLogWriter() {
+	stop_ = true;
+	worker_.join();
+}
+
+void MatchLogWriter::Write(const std::vector<boost::string_ref>& lines) {
+	message_.clear();
+	for (const auto& line : lines) {
+		message_.append(line.data(), line.size());
+		message_ += '\n';
+	}
+	if (!queue_.Fits(message_.size())) {
+		LOG(kError) << "message too large for the log";
+		return;
+	}
+	while (!queue_.Push(message_.data(), message_.size())) {
+		// the writer has fallen behind
+		std::this_thread::yield();
+	}
+}
+
+void MatchLogWriter::Work() {
+	std::unique_ptr<BinaryLogEncoder> encoder;
+	if (binary_) {
+		encoder.reset(new BinaryLogEncoder(output_));
+	}
+
+	std::string message;
+	std::vector<boost::string_ref> lines;
+	for (;;) {
+		// stop_ is read first, so that nothing pushed before it is lost
+		bool stop = stop_;
+		if (!queue_.Pop(message)) {
+			if (stop) {
+				break;
+			}
+			output_.flush();
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			continue;
+		}
+
+		if (encoder) {
+			lines.clear();
+			boost::string_ref text(message);
+			while (!text.empty()) {
+				auto end = text.find('\n');
+				lines.push_back(text.substr(0, end));
+				text.remove_prefix(end + 1);
+			}
+			encoder->Write(lines);
+		} else {
+			output_ << message << ".\n";
+		}
+	}
+	output_.flush();
+}
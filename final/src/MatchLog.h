@@ -0,0 +1,96 @@
+#pragma once
+#include "ByteQueue.h"
+#include "Point.h"
+#include <atomic>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/utility/string_ref.hpp>
+
+// Match logs hold the messages of the server, as the text it sent, with a
+// line holding a single '.' after each, or in a binary form.
+// The binary form starts with kBinaryLogMagic. Turns are stored with a
+// header, their tiles packed into 4 bits and their displays and positions as
+// changes from the previous turn. Other messages, and turns that wouldn't
+// be written back exactly, are stored as text.
+
+extern const char kBinaryLogMagic[8];
+
+// @return	true if filename should hold a binary log
+bool IsBinaryLogName(const std::string& filename);
+
+// Writes messages in the binary form, the magic included
+class BinaryLogEncoder {
+public:
+	explicit BinaryLogEncoder(std::ostream& output);
+
+	void Write(const std::vector<boost::string_ref>& lines);
+
+private:
+	std::ostream& output_;
+	std::string text_;
+	std::string record_;
+	int width_ = -1;
+	int height_ = -1;
+	std::vector<Point> displays_;
+	std::vector<Point> positions_;
+};
+
+// Reads logs of either form
+class MatchLogReader {
+public:
+	explicit MatchLogReader(std::istream& input);
+
+	// @return	the lines of the next message, empty at the end
+	std::vector<std::string> Next();
+
+	// Where the next message starts, with what is needed to decode it from
+	// there
+	struct Position {
+		std::streampos offset;
+		int width = -1;
+		int height = -1;
+		std::vector<Point> displays;
+		std::vector<Point> positions;
+	};
+
+	Position Tell();
+	void Seek(const Position& position);
+
+private:
+	bool ReadTurn(std::vector<std::string>& lines);
+
+	std::istream& input_;
+	bool binary_ = false;
+	int width_ = -1;
+	int height_ = -1;
+	std::vector<Point> displays_;
+	std::vector<Point> positions_;
+};
+
+// Writes a log from a background thread, so that the caller only copies the
+// message into a queue
+class MatchLogWriter {
+public:
+	MatchLogWriter(const std::string& filename, bool binary);
+	~MatchLogWriter();
+
+	MatchLogWriter(const MatchLogWriter&) = delete;
+	MatchLogWriter& operator=(const MatchLogWriter&) = delete;
+
+	// Called from a single thread
+	void Write(const std::vector<boost::string_ref>& lines);
+
+private:
+	void Work();
+
+	std::ofstream output_;
+	bool binary_;
+	ByteQueue queue_;
+	std::string message_;	// reused by Write
+	std::atomic<bool> stop_{false};
+	std::thread worker_;
+};
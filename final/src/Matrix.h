@@ -5,15 +5,19 @@
 #include <cassert>
 #include <ostream>
 #include <algorithm>
+#include <memory>
 
-template<typename T>
+template<typename T, typename Alloc = std::allocator<T>>
 class Matrix {
 public:
+	using Fields = std::vector<T, Alloc>;
+
 	Matrix() = default;
-	Matrix(int width, int height, const T& default_value = T{})
+	Matrix(int width, int height, const T& default_value = T{},
+		const Alloc& alloc = Alloc{})
 		: width_(width)
 		, height_(height)
-		, fields_(width_ * height_, default_value)
+		, fields_(width_ * height_, default_value, alloc)
 	{}
 
 	T& At(const Point& p) {
@@ -37,7 +41,7 @@ public:
     int Width() const { return width_; }
     int Height() const { return height_; }
 
-	void SetFields(std::vector<T> fields) {
+	void SetFields(Fields fields) {
 		assert(fields.size() == width_ * height_);
 		fields_ = std::move(fields);
 	}
@@ -53,7 +57,7 @@ public:
 		}
 	}
 
-	const std::vector<T>& GetFields() const {
+	const Fields& GetFields() const {
 		return fields_;
 	}
 
@@ -73,13 +77,13 @@ public:
 	}
 
 private:
-	int width_;
-	int height_;
-	std::vector<T> fields_;
+	int width_ = 0;
+	int height_ = 0;
+	Fields fields_;
 };
 
-template<typename T>
-std::ostream& operator<<(std::ostream& os, const Matrix<T>& m) {
+template<typename T, typename A>
+std::ostream& operator<<(std::ostream& os, const Matrix<T, A>& m) {
 	for (int y = 0; y < m.Height(); ++y) {
 		for (int x = 0; x < m.Width(); ++x) {
 			os << m.At(x, y) << ' ';
@@ -89,38 +93,55 @@ std::ostream& operator<<(std::ostream& os, const Matrix<T>& m) {
 	return os;
 }
 
-template<typename T>
-T Matrix<T>::Push(const Point& pos, T value) {
-	if (pos.x == -1) {
-		assert(pos.y >= 0 && pos.y < height_);
-		for (int x = width_; x-- > 1; ) {
-			std::swap(At(x, pos.y), At(x - 1, pos.y));
-		}
-		std::swap(At(0, pos.y), value);
-	} else if (pos.x == width_) {
+// A push shifts one row, which is contiguous, or one column, which has a
+// fixed stride, so both are plain moves instead of swaps.
+template<typename T, typename A>
+T Matrix<T, A>::Push(const Point& pos, T value) {
+	T* first;
+	int step;
+	int count;
+	if (pos.x == -1 || pos.x == width_) {
 		assert(pos.y >= 0 && pos.y < height_);
-		for (int x = 0; x < width_ - 1; ++x) {
-			std::swap(At(x, pos.y), At(x + 1, pos.y));
-		}
-		std::swap(At(width_ - 1, pos.y), value);
-	} else if (pos.y == -1) {
+		first = fields_.data() + pos.y * width_;
+		step = 1;
+		count = width_;
+	} else if (pos.y == -1 || pos.y == height_) {
 		assert(pos.x >= 0 && pos.x < width_);
-		for (int y = height_; y-- > 1; ) {
-			std::swap(At(pos.x, y), At(pos.x, y - 1));
+		first = fields_.data() + pos.x;
+		step = width_;
+		count = height_;
+	} else {
+		return value;
+	}
+	int last = (count - 1) * step;
+
+	if (pos.x == -1 || pos.y == -1) {
+		T out = std::move(first[last]);
+		if (step == 1) {
+			std::move_backward(first, first + last, first + last + 1);
+		} else {
+			for (int i = last; i > 0; i -= step) {
+				first[i] = std::move(first[i - step]);
+			}
 		}
-		std::swap(At(pos.x, 0), value);
-	} else if (pos.y == height_) {
-		assert(pos.x >= 0 && pos.x < width_);
-		for (int y = 0; y < height_ - 1; ++y) {
-			std::swap(At(pos.x, y), At(pos.x, y + 1));
+		first[0] = std::move(value);
+		return out;
+	} else {
+		T out = std::move(first[0]);
+		if (step == 1) {
+			std::move(first + 1, first + last + 1, first);
+		} else {
+			for (int i = 0; i < last; i += step) {
+				first[i] = std::move(first[i + step]);
+			}
 		}
-		std::swap(At(pos.x, height_ - 1), value);
+		first[last] = std::move(value);
+		return out;
 	}
-	return value;
 }
 
-template<typename T>
-void Matrix<T>::Rotate(const Point& pos) {
+template<typename T, typename A>
+void Matrix<T, A>::Rotate(const Point& pos) {
 	Point opposite = pos;
 	if (pos.x == -1) {
 		opposite.x = width_-1;
@@ -134,8 +155,8 @@ void Matrix<T>::Rotate(const Point& pos) {
 	Push(pos, At(opposite));
 }
 
-template<typename T>
-void Matrix<T>::RotateBack(const Point& pos) {
+template<typename T, typename A>
+void Matrix<T, A>::RotateBack(const Point& pos) {
 	Point opposite = pos;
 	if (pos.x == -1) {
 		opposite.x = width_;
@@ -0,0 +1,67 @@
+#include "MessageFramer.h"
+#include <cstring>
+
+MessageFramer::MessageFramer(std::size_t capacity) : buffer_(capacity) {}
+
+std::pair<char*, std::size_t> MessageFramer::WriteSpace() {
+	if (consumed_ > 0) {
+		begin_ = line_ = scanned_ = consumed_;
+		consumed_ = 0;
+	}
+	if (buffer_.size() - end_ < buffer_.size() / 2) {
+		Compact();
+		if (buffer_.size() - end_ < buffer_.size() / 2) {
+			buffer_.resize(buffer_.size() * 2);
+		}
+	}
+	return {buffer_.data() + end_, buffer_.size() - end_};
+}
+
+void MessageFramer::Commit(std::size_t bytes) {
+	end_ += bytes;
+}
+
+bool MessageFramer::Next(std::vector<boost::string_ref>& lines) {
+	if (consumed_ > 0) {
+		begin_ = line_ = scanned_ = consumed_;
+		consumed_ = 0;
+	}
+
+	const char* data = buffer_.data();
+	while (scanned_ < end_) {
+		auto newline = static_cast<const char*>(
+			std::memchr(data + scanned_, '\n', end_ - scanned_));
+		if (!newline) {
+			scanned_ = end_;
+			break;
+		}
+
+		std::size_t length = newline - (data + line_);
+		std::size_t next = newline - data + 1;
+		if (length == 1 && data[line_] == '.') {
+			lines.clear();
+			for (const auto& line : lines_) {
+				lines.emplace_back(data + begin_ + line.first, line.second);
+			}
+			lines_.clear();
+			consumed_ = next;
+			return true;
+		}
+		if (length > 0) {
+			lines_.emplace_back(line_ - begin_, length);
+		}
+		line_ = scanned_ = next;
+	}
+	return false;
+}
+
+void MessageFramer::Compact() {
+	if (begin_ == 0) {
+		return;
+	}
+	std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+	line_ -= begin_;
+	scanned_ -= begin_;
+	end_ -= begin_;
+	begin_ = 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <boost/utility/string_ref.hpp>
+
+// Splits the bytes from the server into messages, each ending with a line
+// holding a single '.'. Bytes are received right into the buffer and only
+// the new ones are scanned. Consumed bytes are reclaimed by moving the
+// unread tail to the front, so that lines stay contiguous.
+class MessageFramer {
+public:
+	explicit MessageFramer(std::size_t capacity = 1 << 16);
+
+	// @return	free space to receive into, at least half the capacity
+	std::pair<char*, std::size_t> WriteSpace();
+	// Adds bytes received into WriteSpace()
+	void Commit(std::size_t bytes);
+
+	// Fills lines with the non-empty lines of the next complete message.
+	// They point into the buffer, until the next call to Next or WriteSpace.
+	// @return	false if no message is complete yet
+	bool Next(std::vector<boost::string_ref>& lines);
+
+private:
+	void Compact();
+
+	std::vector<char> buffer_;
+	std::size_t begin_ = 0;		// of the current message
+	std::size_t line_ = 0;		// start of the line being scanned
+	std::size_t scanned_ = 0;
+	std::size_t end_ = 0;		// of the received bytes
+	std::size_t consumed_ = 0;	// returned by the last Next
+
+	// Offsets of the lines of the current message, relative to begin_
+	std::vector<std::pair<std::size_t, std::size_t>> lines_;
+};
@@ -0,0 +1,125 @@
+#include "PersistentGrid.h"
+#include <algorithm>
+
+namespace {
+
+// Moves the points on the pushed line along with the tiles
+void ShiftPoints(const Point& edge, const Point& size, std::vector<Point>& points) {
+	for (auto& p : points) {
+		if (edge.x == -1 && p.y == edge.y) {
+			p.x = (p.x + 1) % size.x;
+		} else if (edge.x == size.x && p.y == edge.y) {
+			p.x = (p.x + size.x - 1) % size.x;
+		} else if (edge.y == -1 && p.x == edge.x) {
+			p.y = (p.y + 1) % size.y;
+		} else if (edge.y == size.y && p.x == edge.x) {
+			p.y = (p.y + size.y - 1) % size.y;
+		}
+	}
+}
+
+// Shifts line by one towards its end if forward, and returns the tile
+// pushed out
+Field ShiftLine(std::vector<Field>& line, bool forward, Field t) {
+	if (forward) {
+		std::swap(line.back(), t);
+		std::rotate(line.begin(), line.end() - 1, line.end());
+	} else {
+		std::swap(line.front(), t);
+		std::rotate(line.begin(), line.begin() + 1, line.end());
+	}
+	return t;
+}
+
+} // namespace
+
+PersistentGrid::PersistentGrid(const Grid& grid) :
+	width_(grid.Width()),
+	height_(grid.Height()),
+	displays_(grid.Displays()),
+	positions_(grid.Positions())
+{
+	auto node = std::make_shared<Node>();
+	node->tiles.reserve(width_ * height_);
+	for (int y = 0; y < height_; ++y) {
+		for (int x = 0; x < width_; ++x) {
+			node->tiles.push_back(grid.At(x, y));
+		}
+	}
+	for (int x = 0; x < width_; ++x) {
+		node->blocked.push_back(grid.IsBlockedX(x));
+	}
+	for (int y = 0; y < height_; ++y) {
+		node->blocked.push_back(grid.IsBlockedY(y));
+	}
+
+	lines_.reserve(height_ + width_);
+	for (int y = 0; y < height_; ++y) {
+		lines_.push_back({node->tiles.data() + y * width_, 0});
+	}
+	for (int x = 0; x < width_; ++x) {
+		lines_.push_back({nullptr, -1});
+	}
+	blocked_ = node->blocked.data();
+	node_ = std::move(node);
+}
+
+std::tuple<PersistentGrid, Field> PersistentGrid::Push(const Point& edge,
+	Field t) const
+{
+	PersistentGrid result = *this;
+	Field extra;
+	++result.time_;
+
+	auto node = std::make_shared<Node>();
+	if (edge.x == -1 || edge.x == width_) {
+		assert(edge.y >= 0 && edge.y < height_);
+		if (IsBlockedY(edge.y)) {
+			throw "Pushed invalid row";
+		}
+		node->tiles = ReadRow(edge.y);
+		extra = ShiftLine(node->tiles, edge.x == -1, t);
+		result.lines_[edge.y] = {node->tiles.data(), result.time_};
+	} else {
+		assert(edge.y == -1 || edge.y == height_);
+		assert(edge.x >= 0 && edge.x < width_);
+		if (IsBlockedX(edge.x)) {
+			throw "Pushed invalid column";
+		}
+		node->tiles = ReadColumn(edge.x);
+		extra = ShiftLine(node->tiles, edge.y == -1, t);
+		result.lines_[height_ + edge.x] = {node->tiles.data(), result.time_};
+	}
+	node->parent = std::move(result.node_);
+	result.node_ = std::move(node);
+
+	ShiftPoints(edge, Size(), result.displays_);
+	ShiftPoints(edge, Size(), result.positions_);
+	return std::make_tuple(std::move(result), extra);
+}
+
+Matrix<Field> PersistentGrid::Fields() const {
+	Matrix<Field> fields(width_, height_);
+	for (int y = 0; y < height_; ++y) {
+		for (int x = 0; x < width_; ++x) {
+			fields.At(x, y) = At(x, y);
+		}
+	}
+	return fields;
+}
+
+std::vector<Field> PersistentGrid::ReadRow(int y) const {
+	std::vector<Field> row(width_);
+	for (int x = 0; x < width_; ++x) {
+		row[x] = At(x, y);
+	}
+	return row;
+}
+
+std::vector<Field> PersistentGrid::ReadColumn(int x) const {
+	std::vector<Field> column(height_);
+	for (int y = 0; y < height_; ++y) {
+		column[y] = At(x, y);
+	}
+	return column;
+}
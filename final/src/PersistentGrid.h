@@ -0,0 +1,67 @@
+#pragma once
+#include "Grid.h"
+#include "Point.h"
+#include "Field.h"
+#include <vector>
+#include <memory>
+#include <tuple>
+
+// Immutable board sharing its tiles with the boards it was pushed from.
+// A push writes the pushed line into a new node that keeps the nodes of the
+// older pushes alive, so it copies one line and touches one reference count.
+// A cell is read from its row or its column overlay, whichever was pushed
+// last. Many sibling boards of a search can be held at once, and read from
+// several threads without locking.
+class PersistentGrid {
+public:
+	PersistentGrid() = default;
+	explicit PersistentGrid(const Grid& grid);
+
+	int Width() const { return width_; }
+	int Height() const { return height_; }
+	Point Size() const { return {width_, height_}; }
+	const std::vector<Point>& Displays() const { return displays_; }
+	const std::vector<Point>& Positions() const { return positions_; }
+	bool IsBlockedX(int x) const { return blocked_[x]; }
+	bool IsBlockedY(int y) const { return blocked_[width_ + y]; }
+
+	Field At(int x, int y) const {
+		const auto& row = lines_[y];
+		const auto& column = lines_[height_ + x];
+		return column.time > row.time ? column.tiles[y] : row.tiles[x];
+	}
+
+	Field At(const Point& p) const {
+		return At(p.x, p.y);
+	}
+
+	// @return	the board with t pushed in at edge, and the tile pushed out
+	std::tuple<PersistentGrid, Field> Push(const Point& edge, Field t) const;
+
+	Matrix<Field> Fields() const;
+
+private:
+	// The tiles written by a push, the whole board for the first one
+	struct Node {
+		std::vector<Field> tiles;
+		std::vector<char> blocked;	// columns, then rows, in the first node
+		std::shared_ptr<const Node> parent;
+	};
+
+	struct Line {
+		const Field* tiles;	// null for a column that wasn't pushed
+		int time;			// push that wrote it
+	};
+
+	std::vector<Field> ReadRow(int y) const;
+	std::vector<Field> ReadColumn(int x) const;
+
+	int width_ = 0;
+	int height_ = 0;
+	int time_ = 0;	// pushes since the Grid
+	std::vector<Line> lines_;	// rows, then columns
+	std::shared_ptr<const Node> node_;	// of the latest push
+	const char* blocked_ = nullptr;		// in the first node
+	std::vector<Point> displays_;
+	std::vector<Point> positions_;
+};
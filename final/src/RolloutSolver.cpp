@@ -0,0 +1,279 @@
+#include "RolloutSolver.h"
+#include "FloodFill.h"
+#include "Util.h"
+#include "DeadlineSolver.h"
+
+#include <atomic>
+#include <limits>
+#include <cstdint>
+
+namespace {
+
+// xorshift64*, cheap enough to be called for every simulated push
+class Random {
+public:
+	explicit Random(std::uint64_t seed) : state_(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+	int Next(int n) {
+		state_ ^= state_ >> 12;
+		state_ ^= state_ << 25;
+		state_ ^= state_ >> 27;
+		return int((state_ * 0x2545F4914F6CDD1Dull) >> 33) % n;
+	}
+
+private:
+	std::uint64_t state_;
+};
+
+// Same distribution as Grid::Randomize
+Field RandomTile(Random& random) {
+	static const int frequencies[] = {7, 13, 10, 1, 1};
+	static const int tiles[] = {1, 3, 7, 5, 15};
+
+	int rnd = random.Next(32);
+	int k = 0;
+	while (rnd >= frequencies[k]) {
+		rnd -= frequencies[k];
+		++k;
+	}
+	Field tile = Field(tiles[k]);
+	for (int i = random.Next(4); i-- > 0;) {
+		tile = RotateLeft(tile);
+	}
+	return tile;
+}
+
+std::vector<Point> PushableEdges(const Grid& grid) {
+	auto size = grid.Size();
+	std::vector<Point> edges;
+	for (int x = 0; x < size.x; ++x) {
+		if (!grid.IsBlockedX(x)) {
+			edges.emplace_back(x, -1);
+			edges.emplace_back(x, size.y);
+		}
+	}
+	for (int y = 0; y < size.y; ++y) {
+		if (!grid.IsBlockedY(y)) {
+			edges.emplace_back(-1, y);
+			edges.emplace_back(size.x, y);
+		}
+	}
+	return edges;
+}
+
+Point Opposite(const Point& edge, const Point& size) {
+	if (edge.x == -1) {
+		return {size.x, edge.y};
+	} else if (edge.x == size.x) {
+		return {-1, edge.y};
+	} else if (edge.y == -1) {
+		return {edge.x, size.y};
+	} else {
+		return {edge.x, -1};
+	}
+}
+
+// @return	the reachable position closest to goal, and its distance
+std::pair<Point, int> ClosestTo(const Grid& grid, const Matrix<int>& reachable,
+	const Point& goal)
+{
+	auto size = grid.Size();
+	Point best;
+	int best_distance = std::numeric_limits<int>::max();
+	ForEachPoint(size, [&](const Point& p) {
+		if (reachable.At(p)) {
+			auto distance = TaxicabDistance(p, goal, size);
+			if (distance < best_distance) {
+				best_distance = distance;
+				best = p;
+			}
+		}
+	});
+	return {best, best_distance};
+}
+
+struct Candidate {
+	PushVariation variation = {};
+	Point move = {};
+	double value = 0;
+	bool evaluated = false;
+};
+
+class Rollout {
+public:
+	Rollout(const Grid& grid, int player, int target, int next_target,
+		const std::vector<Point>& edges)
+		: grid_(grid)
+		, player_(player)
+		, target_(target)
+		, next_target_(next_target)
+		, edges_(edges)
+		, reachable_(grid.Width(), grid.Height(), 0)
+	{}
+
+	void Evaluate(Candidate& candidate, int index, int playouts);
+
+private:
+	double Playout(int goal, Random& random);
+
+	Grid grid_;		// each thread works on its own copy
+	int player_;
+	int target_;
+	int next_target_;
+	const std::vector<Point>& edges_;
+	Matrix<int> reachable_;
+};
+
+void Rollout::Evaluate(Candidate& candidate, int index, int playouts) {
+	const auto& v = candidate.variation;
+#ifndef NDEBUG
+	auto player_pos = grid_.Positions()[player_];
+#endif
+	auto extra = grid_.Push(v.edge, v.tile);
+	auto pushed_pos = grid_.Positions()[player_];
+	auto target_pos = grid_.Displays()[target_];
+
+	reachable_.Fill(0);
+	FloodFillTo(reachable_, grid_.Fields(), pushed_pos);
+
+	int goal = target_;
+	Point move;
+	bool scored = reachable_.At(target_pos);
+	if (scored) {
+		move = target_pos;
+		goal = next_target_;
+		grid_.UpdateDisplay(target_, {});
+	} else {
+		move = ClosestTo(grid_, reachable_, target_pos).first;
+	}
+	grid_.UpdatePosition(player_, move);
+	candidate.move = (move == pushed_pos ? Point{} : move);
+
+	// The seed only depends on the candidate, so results don't depend on
+	// how the work is split between threads
+	Random random(index + 1);
+	double sum = 0;
+	for (int i = 0; i < playouts; ++i) {
+		sum += Playout(goal, random);
+	}
+	candidate.value = (scored ? 1000 : 0) - sum / playouts;
+	candidate.evaluated = true;
+
+	grid_.UpdatePosition(player_, pushed_pos);
+	if (scored) {
+		grid_.UpdateDisplay(target_, target_pos);
+	}
+	grid_.Push(v.opposite_edge, extra);
+	assert(grid_.Positions()[player_] == player_pos);
+}
+
+// @return	how far we stay from goal after the others pushed once each
+double Rollout::Playout(int goal, Random& random) {
+	if (goal < 0) {
+		return 0;
+	}
+
+	auto size = grid_.Size();
+	int opponents = grid_.PlayerCount() - 1;
+	std::vector<std::pair<Point, Field>> undo;
+	undo.reserve(opponents);
+
+	for (int i = 0; i < opponents; ++i) {
+		const auto& edge = edges_[random.Next(edges_.size())];
+		auto extra = grid_.Push(edge, RandomTile(random));
+		undo.emplace_back(Opposite(edge, size), extra);
+	}
+
+	reachable_.Fill(0);
+	FloodFillTo(reachable_, grid_.Fields(), grid_.Positions()[player_]);
+	auto distance = ClosestTo(grid_, reachable_, grid_.Displays()[goal]).second;
+
+	for (auto it = undo.rbegin(); it != undo.rend(); ++it) {
+		grid_.Push(it->first, it->second);
+	}
+	return distance;
+}
+
+// The candidates of one turn, shared by the tasks evaluating them
+struct RolloutTurn {
+	Grid grid;
+	int player;
+	int target;
+	Field field;
+	int next_target;
+	int playouts;
+	std::vector<Point> edges;
+	std::vector<Candidate> candidates;
+	CancelToken cancel;
+	Solver::Callback fn;
+	std::atomic<int> remaining{0};
+};
+
+void EvaluateCandidate(RolloutTurn& turn, int index) {
+	// candidates left when cancelled don't count
+	if (!turn.cancel.Cancelled()) {
+		Rollout rollout(turn.grid, turn.player, turn.target, turn.next_target,
+			turn.edges);
+		rollout.Evaluate(turn.candidates[index], index, turn.playouts);
+	}
+}
+
+void Answer(const RolloutTurn& turn) {
+	const Candidate* best = nullptr;
+	for (const auto& candidate : turn.candidates) {
+		if (candidate.evaluated && (!best || candidate.value > best->value)) {
+			best = &candidate;
+		}
+	}
+	if (!best) {
+		turn.fn(FallbackResponse(turn.grid, turn.player, turn.target, turn.field));
+		return;
+	}
+	turn.fn({{best->variation.edge, best->variation.tile}, best->move});
+}
+
+} // namespace
+
+
+RolloutSolver::RolloutSolver(std::shared_ptr<WorkPool> pool, int playouts)
+	: playouts_(playouts)
+	, pool_(std::move(pool))
+{}
+
+void RolloutSolver::Turn(const Grid& grid, int player, int target, Field field,
+		int nextTarget, Callback fn)
+{
+	auto turn = std::make_shared<RolloutTurn>();
+	turn->grid = grid;
+	turn->player = player;
+	turn->target = target;
+	turn->field = field;
+	turn->next_target = nextTarget;
+	turn->playouts = playouts_;
+	turn->edges = PushableEdges(grid);
+	for (const auto& v : GetPushVariations(grid, field)) {
+		turn->candidates.push_back({v});
+	}
+	turn->cancel = Cancel();
+	turn->fn = std::move(fn);
+
+	int count = turn->candidates.size();
+	if (!pool_ || count == 0) {
+		for (int i = 0; i < count; ++i) {
+			EvaluateCandidate(*turn, i);
+		}
+		Answer(*turn);
+		return;
+	}
+
+	// the last task to finish answers
+	turn->remaining = count;
+	for (int i = 0; i < count; ++i) {
+		pool_->Submit(Deadline(), [turn, i] {
+			EvaluateCandidate(*turn, i);
+			if (--turn->remaining == 0) {
+				Answer(*turn);
+			}
+		});
+	}
+}
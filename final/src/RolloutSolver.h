@@ -0,0 +1,25 @@
+#pragma once
+#include "Solver.h"
+#include "WorkPool.h"
+#include <memory>
+
+// Scores each of our pushes by simulating random pushes of the other players
+// until our next turn. Each push is a task on the pool, as urgent as the
+// turn's deadline, and the last one to finish answers.
+class RolloutSolver : public Solver {
+public:
+	// @param pool	shared with other solvers, Turn works alone if null
+	explicit RolloutSolver(std::shared_ptr<WorkPool> pool = nullptr,
+		int playouts = 64);
+
+	void Init(int player) override {}
+	void Shutdown() override {}
+	void Update(const Grid& grid, int player) override {}
+	void Turn(const Grid& grid, int player, int target, Field field,
+			int nextTarget, Callback fn) override;
+	void Idle() override {}
+
+private:
+	int playouts_;
+	std::shared_ptr<WorkPool> pool_;
+};
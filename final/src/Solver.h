@@ -3,9 +3,12 @@
 #include "Point.h"
 #include "Field.h"
 #include "Response.h"
+#include "CancelToken.h"
+#include <chrono>
 #include <functional>
 
-
+struct FieldInfo;
+struct TickChange;
 
 class Solver {
 public:
@@ -13,6 +16,13 @@ public:
 
 	virtual ~Solver() {}
 	virtual void Init(int player) = 0;
+	// Called after Init, before the first turn of the game, to build what
+	// only depends on the map. budget is zero if there is no time limit.
+	virtual void Precompute(const FieldInfo& info,
+			std::chrono::milliseconds budget) {}
+	// Called on every tick before its Update or Turn, with the change since
+	// the previous tick, so that caches can be invalidated precisely
+	virtual void Changed(const TickChange& change) {}
 	virtual void Shutdown() = 0;
 	virtual void Update(const Grid& grid, int player) = 0;
 	virtual void Turn(const Grid& grid, int player, int target, Field field,
@@ -21,4 +31,34 @@ public:
 
 	Response SyncTurn(const Grid& grid, int player, int target, Field field,
 			int nextTarget);
+
+	// fn receives the best responses found so far during a Turn, if the
+	// solver reports any. It may be called from any thread.
+	void SetProgress(Callback fn) { progress_ = std::move(fn); }
+
+	// Turn should return soon once token is cancelled. Its response is
+	// dropped then, so any valid one does.
+	void SetCancel(CancelToken token) { cancel_ = std::move(token); }
+
+	// When the Turn must be answered, for solvers that schedule work
+	void SetDeadline(std::chrono::steady_clock::time_point deadline) {
+		deadline_ = deadline;
+	}
+
+protected:
+	bool HasProgress() const { return bool(progress_); }
+	void Progress(const Response& response) const {
+		if (progress_) {
+			progress_(response);
+		}
+	}
+	const CancelToken& Cancel() const { return cancel_; }
+	bool Cancelled() const { return cancel_.Cancelled(); }
+	std::chrono::steady_clock::time_point Deadline() const { return deadline_; }
+
+private:
+	Callback progress_;
+	CancelToken cancel_;
+	std::chrono::steady_clock::time_point deadline_ =
+		std::chrono::steady_clock::time_point::max();
 };
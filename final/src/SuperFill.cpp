@@ -3,11 +3,23 @@
 #include "Matrix.h"
 #include "Grid.h"
 #include "SuperFill.h"
+#include "FloodFill.h"
+#include "Components.h"
+#include "ExactSearch.h"
+#include "Evaluators.h"
+#include "Distances.h"
+#include "Arena.h"
+#include "InputParser.h"
+#include "GameState.h"
+#include "Log.h"
 #include <limits>
 #include <cstdint>
 #include <functional>
 #include <chrono>
 #include <set>
+#include <map>
+#include <iterator>
+#include <stdexcept>
 #include <boost/optional.hpp>
 
 namespace {
@@ -46,9 +58,9 @@ void ForeachNeighbors(const FieldMatrix& matrix, const Point& p, F func) {
 	}
 }
 
-template<typename C>
+template<typename C, typename A>
 void FloodFill(const FieldMatrix& matrix,
-	std::vector<std::pair<Point, C>> origins, Matrix<C>& area)
+	ArenaVector<std::pair<Point, C>> origins, Matrix<C, A>& area)
 {
 	auto& stack = origins;
 	assert(matrix.Width() == area.Width());
@@ -69,9 +81,16 @@ void FloodFill(const FieldMatrix& matrix,
 	}
 }
 
+template<typename C>
+ArenaVector<std::pair<Point, C>> Origin(const Point& pos, C value, Arena& arena) {
+	ArenaVector<std::pair<Point, C>> origins(&arena);
+	origins.emplace_back(pos, value);
+	return origins;
+}
+
 template<typename C>
 void RotateOrigins(const Point& edge, const Point& size,
-	std::vector<std::pair<Point, C>>& origins)
+	ArenaVector<std::pair<Point, C>>& origins)
 {
 	if (edge.x == -1) {
 		for (auto& origin : origins) {
@@ -118,39 +137,400 @@ struct SuperMove {
 };
 
 
-using SuperMatrix = Matrix<SuperMove>;
+using SuperMatrix = ArenaMatrix<SuperMove>;
 using SuperOrigin = std::pair<Point, SuperMove>;
 
+// The area only depends on the tiles it contains or opens towards
+Matrix<char> TouchedCells(const Grid& grid, const Matrix<int>& area) {
+	auto size = grid.Size();
+	Matrix<char> touched(size.x, size.y, 0);
+	ForEachPoint(size, [&](const Point& p) {
+		if (!area.At(p)) {
+			return;
+		}
+		touched.At(p) = 1;
+		for (auto dir : {Point{1, 0}, Point{-1, 0}, Point{0, 1}, Point{0, -1}}) {
+			Point q{p.x + dir.x, p.y + dir.y};
+			if (grid.IsInside(q) && IsOpenTowards(grid.At(p), dir)) {
+				touched.At(q) = 1;
+			}
+		}
+	});
+	return touched;
+}
+
+// Finds the result of the same push on our previous turn, if the pushes
+// since then have not changed any tile its area depends on
+class WarmStart {
+public:
+	// @param pushed_edges	since last_grid, null if not known
+	WarmStart(const Grid& last_grid, const FirstPushes& last_pushes,
+		const Grid& grid, const std::vector<Point>* pushed_edges);
+
+	// @param grid	the board after v is pushed
+	const FirstPush* Find(const Grid& grid, const PushVariation& v) const;
+
+private:
+	std::map<Point, const FirstPush*> pushes_;
+	std::vector<Point> changed_;
+};
+
+WarmStart::WarmStart(const Grid& last_grid, const FirstPushes& last_pushes,
+	const Grid& grid, const std::vector<Point>* pushed_edges)
+{
+	if (last_pushes.empty() || last_grid.Size() != grid.Size()) {
+		return;
+	}
+	auto size = grid.Size();
+	if (pushed_edges) {
+		// only the pushed lines may differ
+		Matrix<char> seen(size.x, size.y, 0);
+		for (const auto& edge : *pushed_edges) {
+			bool is_row = edge.x == -1 || edge.x == size.x;
+			int length = is_row ? size.x : size.y;
+			for (int i = 0; i < length; ++i) {
+				Point p = is_row ? Point{i, edge.y} : Point{edge.x, i};
+				if (!seen.At(p) && last_grid.At(p) != grid.At(p)) {
+					changed_.push_back(p);
+				}
+				seen.At(p) = 1;
+			}
+		}
+	} else {
+		ForEachPoint(size, [&](const Point& p) {
+			if (last_grid.At(p) != grid.At(p)) {
+				changed_.push_back(p);
+			}
+		});
+	}
+	for (const auto& push : last_pushes) {
+		if (push.touched.Width() > 0) {
+			pushes_[push.variation.edge] = &push;
+		}
+	}
+}
+
+const FirstPush* WarmStart::Find(const Grid& grid, const PushVariation& v) const {
+	auto it = pushes_.find(v.edge);
+	if (it == pushes_.end()) {
+		return nullptr;
+	}
+
+	const auto& push = *it->second;
+	auto size = grid.Size();
+	bool is_row = v.edge.x == -1 || v.edge.x == size.x;
+	Point shift{0, 0};
+	Point inserted = v.edge;
+	if (v.edge.x == -1) {
+		shift.x = 1;
+		inserted.x = 0;
+	} else if (v.edge.x == size.x) {
+		shift.x = -1;
+		inserted.x = size.x - 1;
+	} else if (v.edge.y == -1) {
+		shift.y = 1;
+		inserted.y = 0;
+	} else {
+		shift.y = -1;
+		inserted.y = size.y - 1;
+	}
+
+	if (push.variation.tile != v.tile && push.touched.At(inserted)) {
+		return nullptr;
+	}
+	for (auto p : changed_) {
+		bool on_line = is_row ? p.y == v.edge.y : p.x == v.edge.x;
+		if (on_line) {
+			p.x += shift.x;
+			p.y += shift.y;
+			if (!grid.IsInside(p)) {
+				continue;
+			}
+		}
+		if (push.touched.At(p)) {
+			return nullptr;
+		}
+	}
+	return &push;
+}
+
+FirstPushes EvaluateFirstPushes(Grid& grid, int player, int target, Field extra,
+	const WarmStart& warm_start, const PushTable& variations, Arena& arena,
+	RelevanceStats& stats)
+{
+	auto size = grid.Size();
+	FirstPushes pushes;
+	int reused = 0;
+	int flooded = 0;
+
+	ComponentMap components(grid, &arena);
+	auto player_label = components.Label(grid.Positions()[player]);
+
+	// Pushes away from the player's component leave it as it is
+	FirstPush unchanged;
+	unchanged.reachable = Matrix<int>(size.x, size.y, 0);
+	FloodFill(grid.Fields(), Origin(grid.Positions()[player], 1, arena),
+		unchanged.reachable);
+	unchanged.reachable_count = components.Size(player_label);
+
+	auto first_variations = variations.Get(extra);
+	pushes.reserve(first_variations.end() - first_variations.begin());
+	for (const auto& v : first_variations) {
+		FirstPush push;
+		push.variation = v;
+		push.moves_player = components.Touches(player_label, v.edge);
+		push.extra = grid.Push(v.edge, v.tile);
+		push.player_pos = grid.Positions()[player];
+		push.target_pos = grid.Displays()[target];
+
+		++stats.pushes;
+		const FirstPush* previous = nullptr;
+		if (!push.moves_player) {
+			++stats.dropped;
+			push.reachable = unchanged.reachable;
+			push.reachable_count = unchanged.reachable_count;
+		} else if ((previous = warm_start.Find(grid, v)) &&
+			previous->reachable.At(push.player_pos))
+		{
+			++reused;
+			push.reachable = previous->reachable;
+			push.reachable_count = previous->reachable_count;
+			push.touched = previous->touched;
+		} else {
+			++flooded;
+			push.reachable = Matrix<int>(size.x, size.y, 0);
+			FloodFill(grid.Fields(), Origin(push.player_pos, 1, arena),
+				push.reachable);
+			push.touched = TouchedCells(grid, push.reachable);
+
+			for (auto x : push.reachable.GetFields()) {
+				push.reachable_count += !!x;
+			}
+		}
+
+		for (const auto& display_pos : grid.Displays()) {
+			if (IsValid(display_pos) && push.reachable.At(display_pos)) {
+				++push.display_count;
+			}
+		}
+
+		grid.Push(v.opposite_edge, push.extra);
+		pushes.push_back(std::move(push));
+	}
+
+	LOG(kDebug) << "Warm start" << logging::Kv("reused", reused)
+		<< logging::Kv("first_pushes", reused + flooded);
+	return pushes;
+}
+
+
+struct PruneStats {
+	int candidates = 0;
+	int pruned_candidates = 0;
+	int pushes = 0;
+	int pruned_pushes = 0;
+};
+
+// Upper bounds of the area features for every pushable line of a board.
+// Tiles off the line keep their connections when it is pushed, so the player
+// can only reach its own component, and if that touches the line, the line
+// itself plus the components opening towards it.
+class FitnessBound {
+public:
+	FitnessBound(const Grid& grid, int player, int next_target, Arena& arena);
+
+	const Features& LineBound(const Point& edge) const;
+
+	template<typename Eval>
+	int MaxBound() const {
+		int max_bound = 0;
+		for (const auto& bound : col_bounds_) {
+			max_bound = std::max(max_bound, Eval::Score(bound));
+		}
+		for (const auto& bound : row_bounds_) {
+			max_bound = std::max(max_bound, Eval::Score(bound));
+		}
+		return max_bound;
+	}
+
+private:
+	Features ComputeLineBound(const Grid& grid, const Point& first, const Point& step,
+		const Point& side);
+
+	ArenaMatrix<int> labels_;
+	ArenaVector<int> component_size_;
+	ArenaVector<int> component_displays_;
+	ArenaVector<int> seen_;
+	ArenaVector<Features> col_bounds_;
+	ArenaVector<Features> row_bounds_;
+	Point player_pos_;
+	Point next_pos_;
+	int player_label_ = 0;
+	int next_label_ = 0;
+	int stamp_ = 0;
+};
+
+FitnessBound::FitnessBound(const Grid& grid, int player, int next_target,
+	Arena& arena)
+	: labels_(FullFloodFill(grid.Fields(), &arena))
+	, component_size_(&arena)
+	, component_displays_(&arena)
+	, seen_(&arena)
+	, col_bounds_(&arena)
+	, row_bounds_(&arena)
+{
+	auto size = grid.Size();
+
+	int label_count = 0;
+	for (auto label : labels_.GetFields()) {
+		label_count = std::max(label_count, label);
+	}
+	component_size_.resize(label_count + 1, 0);
+	component_displays_.resize(label_count + 1, 0);
+	seen_.resize(label_count + 1, 0);
+
+	for (auto label : labels_.GetFields()) {
+		++component_size_[label];
+	}
+	for (const auto& display_pos : grid.Displays()) {
+		if (IsValid(display_pos)) {
+			++component_displays_[labels_.At(display_pos)];
+		}
+	}
+
+	player_pos_ = grid.Positions()[player];
+	player_label_ = labels_.At(player_pos_);
+	if (next_target >= 0 && IsValid(grid.Displays()[next_target])) {
+		next_pos_ = grid.Displays()[next_target];
+		next_label_ = labels_.At(next_pos_);
+	}
+
+	col_bounds_.resize(size.x);
+	row_bounds_.resize(size.y);
+	for (int x = 0; x < size.x; ++x) {
+		if (!grid.IsBlockedX(x)) {
+			col_bounds_[x] = ComputeLineBound(grid, {x, 0}, {0, 1}, {1, 0});
+		}
+	}
+	for (int y = 0; y < size.y; ++y) {
+		if (!grid.IsBlockedY(y)) {
+			row_bounds_[y] = ComputeLineBound(grid, {0, y}, {1, 0}, {0, 1});
+		}
+	}
+}
+
+Features FitnessBound::ComputeLineBound(const Grid& grid,
+	const Point& first, const Point& step, const Point& side)
+{
+	auto on_line = [&](const Point& p) {
+		return step.x == 0 ? p.x == first.x : p.y == first.y;
+	};
+
+	// Components that can be entered from the line after the push
+	++stamp_;
+	bool player_touches_line = on_line(player_pos_);
+	int line_length = 0;
+	for (Point p = first; grid.IsInside(p); p.x += step.x, p.y += step.y) {
+		++line_length;
+		Point before{p.x - side.x, p.y - side.y};
+		Point after{p.x + side.x, p.y + side.y};
+		if (grid.IsInside(before) && IsOpenTowards(grid.At(before), side)) {
+			seen_[labels_.At(before)] = stamp_;
+		}
+		if (grid.IsInside(after) && IsOpenTowards(grid.At(after), {-side.x, -side.y})) {
+			seen_[labels_.At(after)] = stamp_;
+		}
+	}
+	player_touches_line = player_touches_line || seen_[player_label_] == stamp_;
+
+	Features bound;
+	if (!player_touches_line) {
+		// The player's area can only shrink
+		bound.cells = component_size_[player_label_];
+		bound.displays = component_displays_[player_label_];
+		bound.next_target =
+			(next_label_ == player_label_ && !on_line(next_pos_)) ? 1 : 0;
+		return bound;
+	}
+	seen_[player_label_] = stamp_;
+
+	int cells = line_length;
+	int displays = 0;
+	for (int label = 1, ie = seen_.size(); label < ie; ++label) {
+		if (seen_[label] == stamp_) {
+			cells += component_size_[label];
+			displays += component_displays_[label];
+		}
+	}
+	for (const auto& display_pos : grid.Displays()) {
+		if (IsValid(display_pos) && on_line(display_pos) &&
+			seen_[labels_.At(display_pos)] != stamp_)
+		{
+			++displays;
+		}
+	}
+
+	bool next = IsValid(next_pos_) &&
+		(on_line(next_pos_) || seen_[next_label_] == stamp_);
+
+	bound.cells = cells;
+	bound.displays = displays;
+	bound.next_target = next ? 1 : 0;
+	return bound;
+}
+
+const Features& FitnessBound::LineBound(const Point& edge) const {
+	if (edge.x == -1 || edge.x == static_cast<int>(col_bounds_.size())) {
+		return row_bounds_[edge.y];
+	}
+	return col_bounds_[edge.x];
+}
+
+// Only reports fitness values above cutoff exactly; lines whose bound can't
+// beat it are skipped.
+template<typename Eval>
+int Fitness(Grid& grid, int player, Field extra, int next_target,
+	const FitnessBound& bound, int cutoff, const PushTable& variations,
+	Arena& arena, PruneStats& stats)
+{
+	static_assert(evaluators::IsMonotone<Eval>(),
+		"area evaluators must not decrease in the area features");
 
-int Fitness(Grid& grid, int player, Field extra, int next_target) {
 	auto size = grid.Size();
 	int best_fitness = 0;
+	ArenaMatrix<int> reachable(size.x, size.y, 0, &arena);
+
+	for (const auto& v : variations.Get(extra)) {
+		++stats.pushes;
+		auto line_bound = Eval::Score(bound.LineBound(v.edge));
+		if (line_bound <= std::max(best_fitness, cutoff)) {
+			++stats.pruned_pushes;
+			continue;
+		}
 
-	for (const auto& v : GetPushVariations(grid, extra)) {
 		auto field = grid.Push(v.edge, v.tile);
 		auto player_pos = grid.Positions()[player];
-		Matrix<int> reachable(size.x, size.y, 0);
-		FloodFill(grid.Fields(), {{player_pos, 1}}, reachable);
+		reachable.Fill(0);
+		FloodFill(grid.Fields(), Origin(player_pos, 1, arena), reachable);
 
-		int display_count = 0;
-		int filled_count = 0;
+		Features features;
 		int display = -1;
-		int next_count = 0;
 		for (const auto& display_pos : grid.Displays()) {
 			++display;
 			if (IsValid(display_pos) && reachable.At(display_pos)) {
-				++display_count;
+				++features.displays;
 				if (display == next_target) {
-					next_count += 1;
+					features.next_target += 1;
 				}
 			}
 		}
 
 		for (auto x : reachable.GetFields()) {
-			filled_count += !!x;
+			features.cells += !!x;
 		}
 
-		int current_fitness = display_count + filled_count + next_count * 10;
+		int current_fitness = Eval::Score(features);
+		assert(current_fitness <= line_bound);
 		best_fitness = std::max(best_fitness, current_fitness);
 		grid.Push(v.opposite_edge, field);
 	}
@@ -158,123 +538,189 @@ int Fitness(Grid& grid, int player, Field extra, int next_target) {
 	return best_fitness;
 }
 
-boost::optional<Response> SingleMove(
-	Grid& grid, int player, int target, Field extra, int nextTarget)
+template<typename Eval>
+boost::optional<Response> SingleMove(Grid& grid, int player, int target,
+	int nextTarget, const FirstPushes& pushes, const PushTable& variations,
+	Arena& arena, PruneStats& stats)
 {
-	auto size = grid.Size();
-	int best_fitness = 0;
-	boost::optional<Response> response;
+	struct Candidate {
+		int index;
+		int bound;
+		FitnessBound fitness_bound;
+	};
+	ArenaVector<Candidate> candidates(&arena);
+	candidates.reserve(pushes.size());
+
+	for (int i = 0, ie = pushes.size(); i < ie; ++i) {
+		const auto& push = pushes[i];
+		if (!push.reachable.At(push.target_pos)) {
+			continue;
+		}
 
-	for (const auto& v : GetPushVariations(grid, extra)) {
-		auto field = grid.Push(v.edge, v.tile);
-		auto player_pos = grid.Positions()[player];
-		auto target_pos = grid.Displays()[target];
-		Matrix<int> reachable(size.x, size.y, 0);
+		const auto& v = push.variation;
+		grid.Push(v.edge, v.tile);
+		grid.UpdatePosition(player, push.target_pos);
+		grid.UpdateDisplay(target, {});
 
-		FloodFill(grid.Fields(), {{player_pos, 1}}, reachable);
-		if (reachable.At(target_pos)) {
-			grid.UpdatePosition(player, target_pos);
-			grid.UpdateDisplay(target, {});
+		FitnessBound fitness_bound(grid, player, nextTarget, arena);
+		auto bound = fitness_bound.MaxBound<typename Eval::Area>();
+		candidates.push_back({i, bound, std::move(fitness_bound)});
 
-			auto fitness = Fitness(grid, player, field, nextTarget);
-			if (fitness > best_fitness) {
-				best_fitness = fitness;
-				response = {{v.edge, v.tile}, target_pos};
-			}
+		grid.UpdateDisplay(target, push.target_pos);
+		grid.UpdatePosition(player, push.player_pos);
+		grid.Push(v.opposite_edge, push.extra);
+	}
 
-			grid.UpdateDisplay(target, target_pos);
-			grid.UpdatePosition(player, player_pos);
-		}
+	std::stable_sort(candidates.begin(), candidates.end(),
+		[](const Candidate& lhs, const Candidate& rhs) {
+			return lhs.bound > rhs.bound;
+		});
 
-		grid.Push(v.opposite_edge, field);
-	}
-	return response;
-}
+	int best_fitness = 0;
+	int best_index = -1;
+	boost::optional<Response> response;
 
-int Proximity(const Grid& grid, const Point& p, const Point& q) {
-	auto size = grid.Size();
-	auto dx = std::abs(p.x - q.x);
-	auto dy = std::abs(p.y - q.y);
+	for (const auto& candidate : candidates) {
+		// ties go to the earlier push, as if evaluated in push order
+		int cutoff = best_fitness;
+		if (best_index >= 0 && candidate.index < best_index) {
+			cutoff -= 1;
+		}
 
-	dx = std::min(dx, size.x - dx);
-	dy = std::min(dy, size.y - dy);
+		++stats.candidates;
+		if (candidate.bound <= cutoff) {
+			++stats.pruned_candidates;
+			continue;
+		}
 
-	auto dst = dx + dy;
+		const auto& push = pushes[candidate.index];
+		const auto& v = push.variation;
+		grid.Push(v.edge, v.tile);
+		grid.UpdatePosition(player, push.target_pos);
+		grid.UpdateDisplay(target, {});
+
+		auto fitness = Fitness<typename Eval::Area>(grid, player, push.extra, nextTarget,
+			candidate.fitness_bound, cutoff, variations, arena, stats);
+		if (fitness > cutoff) {
+			best_fitness = fitness;
+			best_index = candidate.index;
+			response = Response{{v.edge, v.tile}, push.target_pos};
+		}
 
-	if (dx == 0) {
-		dst += dy;
-	} else if (dy == 0) {
-		dst += dx;
+		grid.UpdateDisplay(target, push.target_pos);
+		grid.UpdatePosition(player, push.player_pos);
+		grid.Push(v.opposite_edge, push.extra);
 	}
-
-	return dst;
+	return response;
 }
 
-int BasicFitness(const Grid& grid, const Point& pos) {
+Features AreaFeatures(const Grid& grid, const Point& pos, Arena& arena) {
 	auto size = grid.Size();
-	Matrix<int> reachable(size.x, size.y, 0);
-	FloodFill(grid.Fields(), {{pos, 1}}, reachable);
+	ArenaMatrix<int> reachable(size.x, size.y, 0, &arena);
+	FloodFill(grid.Fields(), Origin(pos, 1, arena), reachable);
 
-	int display_count = 0;
-	int filled_count = 0;
+	Features features;
 	for (const auto& display_pos : grid.Displays()) {
 		if (IsValid(display_pos) && reachable.At(display_pos)) {
-			++display_count;
+			++features.displays;
 		}
 	}
 
 	for (auto x : reachable.GetFields()) {
-		filled_count += !!x;
+		features.cells += !!x;
 	}
 
-	return display_count + filled_count;
+	return features;
 }
 
-boost::optional<Response> DoubleMove(
-	Grid& grid, int player, int target, Field extra, int nextTarget)
+template<typename Eval>
+boost::optional<Response> DoubleMove(Grid& grid, int player, int target,
+	int nextTarget, const FirstPushes& pushes, const DistanceTable& distances,
+	const PushTable& variations, Arena& arena, const Solver::Callback& progress,
+	const CancelToken& cancel, RelevanceStats& stats)
 {
 	auto size = grid.Size();
+	SuperMatrix reachable2(size.x, size.y, {}, &arena);
 	boost::optional<Response> response;
 	int best_fitness = 0;
 	int best_number_of_good_pushes = 0;
 	int best_distance = std::numeric_limits<int>::max();
+	int first_pushes = 0;
+	int hopeless_pushes = 0;
 
-	for (const auto& v : GetPushVariations(grid, extra)) {
+	for (const auto& push : pushes) {
+		if (cancel.Cancelled()) {
+			LOG(kDebug) << "Double Move: cancelled";
+			break;
+		}
+		++stats.pushes;
+
+		const auto& v = push.variation;
 		auto field = grid.Push(v.edge, v.tile);
-		auto player_pos = grid.Positions()[player];
-		auto target_pos = grid.Displays()[target];
-		Matrix<int> reachable(size.x, size.y, 0);
-		std::vector<SuperOrigin> origins;
-		std::set<Point> move_candidates;
+		auto player_pos = push.player_pos;
+		auto target_pos = push.target_pos;
+		ArenaVector<SuperOrigin> origins(&arena);
+		ArenaSet<Point> move_candidates(&arena);
+
+		// SingleMove failed, so the player's and the target's components
+		// differ, and the second push has to join them
+		ComponentMap components(grid, &arena);
+		auto player_label = components.Label(player_pos);
+		auto target_label = components.Label(target_pos);
+		ArenaSet<Point> second_edges(&arena);
+		for (const auto& v2 : variations.Get(field)) {
+			if (components.Touches(player_label, v2.edge) &&
+				components.Touches(target_label, v2.edge) &&
+				components.MayJoinWithPush(grid, player_label, target_pos, v2.edge))
+			{
+				second_edges.insert(v2.edge);
+			}
+		}
 
-		FloodFill(grid.Fields(), {{player_pos, 1}}, reachable);
-		reachable.ForeachField([&](const Point& pos, int& cell) {
-			if (cell) {
+		++first_pushes;
+		if (second_edges.empty()) {
+			++hopeless_pushes;
+			grid.Push(v.opposite_edge, field);
+			continue;
+		}
+
+		ForEachPoint(size, [&](const Point& pos) {
+			if (push.reachable.At(pos)) {
 				origins.emplace_back(pos, pos);
 			}
 		});
 
 		int number_of_good_pushes = 0;
-		for (const auto& v2 : GetPushVariations(grid, field)) {
+		for (const auto& v2 : variations.Get(field)) {
+			++stats.pushes;
+			if (!second_edges.count(v2.edge)) {
+				++stats.dropped;
+				continue;
+			}
+
 			auto field2 = grid.Push(v2.edge, v2.tile);
 			auto target_pos2 = grid.Displays()[target];
-			Matrix<SuperMove> reachable2(size.x, size.y, {});
+			reachable2.Fill({});
 			RotateOrigins(v2.edge, size, origins);
 			FloodFill(grid.Fields(), origins, reachable2);
 
 			auto cell = reachable2.At(target_pos2);
-			if (cell) {
-#if 0
-				auto fitness = BasicFitness(grid, target_pos2);
+			if (cell && Eval::double_move_by_area) {
+				auto fitness = Eval::Area::Score(
+					AreaFeatures(grid, target_pos2, arena));
 				if (fitness > best_fitness) {
 					const auto& move = cell.move;
 					auto opt_move = (move == player_pos ? Point{} : move);
 					best_fitness = fitness;
-					response = {{v.edge, v.tile}, opt_move};
+					response = Response{{v.edge, v.tile}, opt_move};
+					if (progress) {
+						progress(*response);
+					}
 				}
-#else
+			} else if (cell) {
 				move_candidates.insert(cell.move);
-#endif
+			}
+			if (cell) {
 				++number_of_good_pushes;
 			}
 
@@ -282,116 +728,88 @@ boost::optional<Response> DoubleMove(
 			grid.Push(v2.opposite_edge, field2);
 		}
 
-#if 1
 		for (const auto& move : move_candidates) {
 			grid.UpdatePosition(player, move);
 
-			auto distance = Proximity(grid, move, target_pos);
-			auto fitness = 40 - distance + number_of_good_pushes * 5;
+			Features features;
+			features.distance = distances.Proximity(move, target_pos);
+			features.good_pushes = number_of_good_pushes;
+			auto fitness = Eval::Approach::Score(features);
 			if (fitness > best_fitness) {
 				auto opt_move = (move == player_pos ? Point{} : move);
 				best_fitness = fitness;
-				best_distance = distance;
+				best_distance = features.distance;
 				best_number_of_good_pushes = number_of_good_pushes;
-				response = {{v.edge, v.tile}, opt_move};
+				response = Response{{v.edge, v.tile}, opt_move};
+				if (progress) {
+					progress(*response);
+				}
 			}
 
 			grid.UpdatePosition(player, player_pos);
 		}
-#endif
 
 		grid.Push(v.opposite_edge, field);
 	}
+	LOG(kDebug) << "Double Move" << logging::Kv("hopeless", hopeless_pushes)
+		<< logging::Kv("first_pushes", first_pushes);
 	if (response) {
-		std::cerr << "Double Move: best_distance = " << best_distance
-				<< ", best_number_of_good_pushes = " << best_number_of_good_pushes
-				<< std::endl;
+		LOG(kDebug) << "Double Move" << logging::Kv("best_distance", best_distance)
+			<< logging::Kv("good_pushes", best_number_of_good_pushes);
 	}
 	return response;
 }
 
-int ConvergeDistance(const Grid& grid, const Point& p, const Point& q, int penalty) {
-	auto size = grid.Size();
-	auto dx = std::abs(p.x - q.x);
-	auto dy = std::abs(p.y - q.y);
-	auto over_edge = (dx > size.x - dx || dy > size.y - dy);
-
-	dx = std::min(dx, size.x - dx);
-	dy = std::min(dy, size.y - dy);
-	auto dst = dx + dy;
-
-	if (grid.IsNeighbor(p, q)) {
-		if (p.x == q.x) {
-			// column
-			auto top_dst = std::min(p.y, q.y);
-			auto bottom_dst = size.y - 1 - std::max(p.y, q.y);
-			dst += std::min(top_dst, bottom_dst);
-			if (top_dst == bottom_dst) {
-				dst += 1;
-			}
-		} else if (p.y == q.y) {
-			// row
-			auto left_dst = std::min(p.x, q.x);
-			auto right_dst = size.x - 1 - std::max(p.x, q.x);
-			dst += std::min(left_dst, right_dst);
-			if (left_dst == right_dst) {
-				dst += 1;
-			}
-		} else {
-			// huh?
-		}
-	} else {
-		// penalize other positions
-		dst += 10;
-		if (over_edge) {
-			dst += 2;
-		}
-	}
-
-	if ((dx == 0 && dy > 1) || (dy == 0 && dx > 1)) {
-		dst += penalty;
-	}
-
-	return dst;
-}
-
-boost::optional<Response> ConvergeMove(
-	Grid& grid, int player, int target, Field extra, int nextTarget)
+template<typename Eval>
+boost::optional<Response> ConvergeMove(Grid& grid, int player, int target,
+	int nextTarget, const FirstPushes& pushes, const DistanceTable& distances)
 {
 	auto size = grid.Size();
 	boost::optional<Response> response;
 	int best_distance = std::numeric_limits<int>::max();
 	int best_fitness = std::numeric_limits<int>::min();
 
-	for (const auto& v : GetPushVariations(grid, extra)) {
-		auto field = grid.Push(v.edge, v.tile);
-		auto player_pos = grid.Positions()[player];
-		auto target_pos = grid.Displays()[target];
-		Matrix<int> reachable(size.x, size.y, 0);
-
-		FloodFill(grid.Fields(), {{player_pos, 1}}, reachable);
-		reachable.ForeachField([&](const Point& pos, int& cell) {
-			if (cell) {
-				auto distance = ConvergeDistance(grid, pos, target_pos, 3);
-				auto fitness = -distance * 4;
-				if (player_pos == pos) {
-					fitness -= 1;
-				}
-				if (grid.IsBlockedX(pos.x)) {
-					fitness += 1;
-				}
-				if (grid.IsBlockedY(pos.y)) {
-					fitness += 1;
-				}
+	// Converge evaluators are sums of terms, so the distance and blocked line
+	// terms are added up once per target position in a table of scores
+	using Converge = typename Eval::Converge;
+	constexpr int base = Converge::Score({});
+	constexpr int distance_weight =
+		Converge::Score(evaluators::Unit(&Features::distance)) - base;
+	constexpr int stays_weight =
+		Converge::Score(evaluators::Unit(&Features::stays)) - base;
+	constexpr int blocked_weight =
+		Converge::Score(evaluators::Unit(&Features::blocked_lines)) - base;
+
+	// Only pushes along the target's line move it
+	std::vector<std::pair<Point, Matrix<int>>> target_scores;
+	auto scores_to = [&](const Point& target_pos) -> const Matrix<int>& {
+		for (const auto& entry : target_scores) {
+			if (entry.first == target_pos) {
+				return entry.second;
+			}
+		}
+		target_scores.emplace_back(target_pos, distances.ConvergeTo(
+			target_pos, distance_weight, blocked_weight));
+		return target_scores.back().second;
+	};
+
+	// Only reads the board geometry, so the pushes need not be replayed
+	for (const auto& push : pushes) {
+		const auto& v = push.variation;
+		auto player_pos = push.player_pos;
+		const auto& target_score = scores_to(push.target_pos);
+
+		ForEachPoint(size, [&](const Point& pos) {
+			if (push.reachable.At(pos)) {
+				auto fitness = base + target_score.At(pos) +
+					(player_pos == pos ? stays_weight : 0);
 				if (fitness > best_fitness) {
 					auto opt_move = (pos == player_pos ? Point{} : pos);
 					best_fitness = fitness;
-					response = {{v.edge, v.tile}, opt_move};
+					response = Response{{v.edge, v.tile}, opt_move};
 				}
 			}
 		});
-
-		grid.Push(v.opposite_edge, field);
 	}
 
 	return response;
@@ -399,16 +817,18 @@ boost::optional<Response> ConvergeMove(
 
 using Clock = std::chrono::steady_clock;
 
-void TimeStat(const std::string& info, Clock::time_point start_t) {
-	using MilliSec = std::chrono::milliseconds;
-	auto end_t = Clock::now();
-	std::cerr << info << " ";
-	std::cerr << std::chrono::duration_cast<MilliSec>(end_t - start_t).count();
-	std::cerr << " ms" << std::endl;
+void TimeStat(const char* info, Clock::time_point start_t) {
+	using MilliSec = std::chrono::duration<double, std::milli>;
+	LOG(kInfo) << "Time" << logging::Kv("phase", info)
+		<< logging::Kv("ms", MilliSec(Clock::now() - start_t).count());
 }
 
-Response SuperFill(
-		Grid grid, int player, int target, Field extra, int nextTarget) {
+template<typename Eval>
+Response SuperFill(Grid grid, int player, int target, Field extra,
+		int nextTarget, const WarmStart& warm_start,
+		const DistanceTable& distances, const PushTable& variations,
+		Arena& arena, const Solver::Callback& progress, const CancelToken& cancel,
+		FirstPushes& pushes) {
 	auto start_t = Clock::now();
 	const int max_depth = 2;
 
@@ -420,19 +840,64 @@ Response SuperFill(
 	auto display_pos = grid.Displays()[target];
 	auto size = grid.Size();
 
-	auto single_move = SingleMove(grid, player, target, extra, nextTarget);
+	RelevanceStats relevance;
+	pushes = EvaluateFirstPushes(grid, player, target, extra, warm_start,
+		variations, arena, relevance);
+
+	PruneStats stats;
+	auto single_move = SingleMove<Eval>(grid, player, target, nextTarget, pushes,
+		variations, arena, stats);
 	if (single_move) {
+		LOG(kDebug) << "Single Move"
+			<< logging::Kv("pruned_candidates", stats.pruned_candidates)
+			<< logging::Kv("candidates", stats.candidates)
+			<< logging::Kv("pruned_pushes", stats.pruned_pushes)
+			<< logging::Kv("pushes", stats.pushes);
 		TimeStat("SINGLEMOVE", start_t);
 		return *single_move;
 	}
 
-	auto double_move = DoubleMove(grid, player, target, extra, nextTarget);
-	if (double_move) {
-		TimeStat("DOUBLEMOVE", start_t);
-		return *double_move;
+	if (UseExactSearch(grid)) {
+		int turns = 0;
+		ExactSearchLimits limits;
+		limits.cancel = cancel;
+		auto exact_move = ExactSearch(grid, player, target, extra, limits, &turns);
+		if (exact_move) {
+			LOG(kDebug) << "Exact search" << logging::Kv("turns", turns);
+			TimeStat("EXACT", start_t);
+			return *exact_move;
+		}
 	}
 
-	auto converge_move = ConvergeMove(grid, player, target, extra, nextTarget);
+	// Cheap, so that an overrunning DoubleMove has something to fall back to
+	boost::optional<Response> converge_move;
+	if (progress) {
+		converge_move = ConvergeMove<Eval>(grid, player, target, nextTarget,
+			pushes, distances);
+		if (converge_move) {
+			progress(*converge_move);
+		}
+	}
+
+	ComponentMap components(grid, &arena);
+	auto player_label = components.Label(player_pos);
+	auto target_label = components.Label(display_pos);
+	if (components.MayJoinInTwoPushes(player_label, target_label)) {
+		auto double_move = DoubleMove<Eval>(grid, player, target, nextTarget,
+			pushes, distances, variations, arena, progress, cancel, relevance);
+		LOG(kDebug) << "Relevance: " << relevance;
+		if (double_move) {
+			TimeStat("DOUBLEMOVE", start_t);
+			return *double_move;
+		}
+	} else {
+		LOG(kDebug) << "Double Move: impossible";
+	}
+
+	if (!converge_move) {
+		converge_move = ConvergeMove<Eval>(grid, player, target, nextTarget,
+			pushes, distances);
+	}
 	if (converge_move) {
 		TimeStat("CONVERGE", start_t);
 		return *converge_move;
@@ -442,12 +907,112 @@ Response SuperFill(
 	return response;
 }
 
+using SuperFillFunction = Response(*)(Grid grid, int player, int target,
+	Field extra, int nextTarget, const WarmStart& warm_start,
+	const DistanceTable& distances, const PushTable& variations,
+	Arena& arena, const Solver::Callback& progress, const CancelToken& cancel,
+	FirstPushes& pushes);
+
+struct EvaluationEntry {
+	const char* name;
+	SuperFillFunction function;
+};
+
+const EvaluationEntry evaluations[] = {
+	{"default", &SuperFill<DefaultEvaluation>},
+	{"area", &SuperFill<AreaEvaluation>},
+	{"blocked", &SuperFill<BlockedEvaluation>},
+};
+
+int FindEvaluation(const std::string& name) {
+	for (int i = 0, ie = std::end(evaluations) - std::begin(evaluations); i < ie; ++i) {
+		if (name == evaluations[i].name) {
+			return i;
+		}
+	}
+	return -1;
+}
+
 } // namespace
 
+SuperSolver::SuperSolver(const std::string& evaluation) :
+	evaluation_(FindEvaluation(evaluation))
+{
+	if (evaluation_ < 0) {
+		throw std::invalid_argument("unknown evaluation: " + evaluation);
+	}
+}
+
+std::vector<std::string> SuperSolver::Evaluations() {
+	std::vector<std::string> names;
+	for (const auto& entry : evaluations) {
+		names.push_back(entry.name);
+	}
+	return names;
+}
+
+void SuperSolver::Init(int player) {
+	last_grid_ = {};
+	last_pushes_.clear();
+	pushed_edges_.clear();
+	changes_ = 0;
+	rebuilt_ = false;
+}
+
+void SuperSolver::Changed(const TickChange& change) {
+	++changes_;
+	if (change.rebuilt) {
+		rebuilt_ = true;
+	} else if (change.delta) {
+		pushed_edges_.push_back(change.delta->edge);
+	}
+}
+
+void SuperSolver::Shutdown() {
+	last_grid_ = {};
+	last_pushes_.clear();
+	pushed_edges_.clear();
+	changes_ = 0;
+	rebuilt_ = false;
+}
+
+void SuperSolver::Precompute(const FieldInfo& info,
+		std::chrono::milliseconds budget)
+{
+	auto grid = MapGrid(info, InputParser::kMaxPlayers);
+	distances_ = DistanceTable{grid.Size(), info.blocked_fields};
+	push_table_ = PushTable{grid};
+}
 
 void SuperSolver::Turn(const Grid& grid, int player, int target, Field field,
 		int nextTarget, Callback fn)
 {
-	Response response = SuperFill(grid, player, target, field, nextTarget);
+	// Without a Precompute, or if the map has changed since
+	if (!push_table_.Matches(grid)) {
+		distances_ = DistanceTable{grid.Size(), grid.BlockedFields()};
+		push_table_ = PushTable{grid};
+	}
+
+	Callback progress;
+	if (HasProgress()) {
+		progress = [this](const Response& response) { Progress(response); };
+	}
+
+	FirstPushes pushes;
+	// Without reported changes, as when driven without a client, the whole
+	// board is compared
+	bool edges_known = changes_ > 0 && !rebuilt_;
+	WarmStart warm_start(last_grid_, last_pushes_, grid,
+		edges_known ? &pushed_edges_ : nullptr);
+	Response response = evaluations[evaluation_].function(grid, player, target,
+		field, nextTarget, warm_start, distances_, push_table_, arena_,
+		progress, Cancel(), pushes);
+
+	last_grid_ = grid;
+	last_pushes_ = std::move(pushes);
+	pushed_edges_.clear();
+	changes_ = 0;
+	rebuilt_ = false;
+	arena_.Release();
 	fn(response);
 }
@@ -1,13 +1,56 @@
 #pragma once
 #include "Solver.h"
+#include "Matrix.h"
+#include "Util.h"
+#include "Distances.h"
+#include "Arena.h"
+#include <vector>
+#include <string>
+
+// State after one of our possible pushes, shared by all phases of a turn
+struct FirstPush {
+	PushVariation variation;
+	Field extra;			// tile pushed out of the board
+	Point player_pos;
+	Point target_pos;
+	Matrix<int> reachable;	// 1 where the player can move after the push
+	Matrix<char> touched;	// reachable tiles and the ones they open towards
+	int reachable_count = 0;
+	int display_count = 0;
+	bool moves_player = false;	// the push may change the player's component
+};
+
+using FirstPushes = std::vector<FirstPush>;
 
 class SuperSolver : public Solver {
 public:
-	void Init(int player) override {}
-	void Shutdown() override {}
+	// evaluation is one of Evaluations(), see Evaluators.h
+	explicit SuperSolver(const std::string& evaluation = "default");
+
+	static std::vector<std::string> Evaluations();
+
+	void Init(int player) override;
+	void Precompute(const FieldInfo& info,
+			std::chrono::milliseconds budget) override;
+	void Changed(const TickChange& change) override;
+	void Shutdown() override;
 	void Update(const Grid& grid, int player) override {}
 	void Turn(const Grid& grid, int player, int target, Field field,
 			int nextTarget, Callback fn) override;
 	void Idle() override {}
-};
 
+private:
+	int evaluation_ = 0;
+	DistanceTable distances_;
+	PushTable push_table_;	// of the current map
+	Arena arena_;	// temporaries of a turn
+
+	// Kept from our previous turn, to reuse what the pushes since then
+	// haven't changed
+	Grid last_grid_;
+	FirstPushes last_pushes_;
+	// Edges pushed since, if every change has been reported
+	std::vector<Point> pushed_edges_;
+	int changes_ = 0;
+	bool rebuilt_ = false;
+};
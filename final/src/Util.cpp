@@ -18,6 +18,18 @@ bool IsSouthOpen(Field type) {
 	return type & 0b0100;
 }
 
+bool IsOpenTowards(Field type, const Point& direction) {
+	if (direction.x == 1) {
+		return IsEastOpen(type);
+	} else if (direction.x == -1) {
+		return IsWestOpen(type);
+	} else if (direction.y == 1) {
+		return IsSouthOpen(type);
+	} else {
+		return IsNorthOpen(type);
+	}
+}
+
 Field RotateLeft(Field tile) {
     return Field((tile >> 3) + ((tile << 1) & 0xf));
 }
@@ -181,3 +193,32 @@ std::ostream& operator<<(std::ostream& os, const PushVariation& push) {
 	os << "(" << push.edge << ", " << push.tile << ")";
 	return os;
 }
+
+PushTable::PushTable(const Grid& grid) : size_(grid.Size()) {
+	for (int x = 0; x < size_.x; ++x) {
+		blocked_.push_back(grid.IsBlockedX(x));
+	}
+	for (int y = 0; y < size_.y; ++y) {
+		blocked_.push_back(grid.IsBlockedY(y));
+	}
+	for (int tile = 1; tile < 16; ++tile) {
+		variations_[tile] = GetPushVariations(grid, Field(tile));
+	}
+}
+
+bool PushTable::Matches(const Grid& grid) const {
+	if (grid.Size() != size_) {
+		return false;
+	}
+	for (int x = 0; x < size_.x; ++x) {
+		if (blocked_[x] != grid.IsBlockedX(x)) {
+			return false;
+		}
+	}
+	for (int y = 0; y < size_.y; ++y) {
+		if (blocked_[size_.x + y] != grid.IsBlockedY(y)) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -10,6 +10,7 @@ bool IsNorthOpen(Field type);
 bool IsSouthOpen(Field type);
 bool IsWestOpen(Field type);
 bool IsEastOpen(Field type);
+bool IsOpenTowards(Field type, const Point& direction);
 
 Field RotateLeft(Field tile);
 Field RotateRight(Field tile);
@@ -47,6 +48,26 @@ std::vector<PushVariation> GetPushVariations(const Grid& grid, Field extra);
 
 std::ostream& operator<<(std::ostream& os, const PushVariation& push);
 
+// GetPushVariations of a map for every extra tile. They only depend on the
+// size of the board and its blocked lines.
+class PushTable {
+public:
+	PushTable() = default;
+	explicit PushTable(const Grid& grid);
+
+	// @return	true if grid has the same size and blocked lines
+	bool Matches(const Grid& grid) const;
+
+	const std::vector<PushVariation>& Get(Field extra) const {
+		return variations_[extra & 15];
+	}
+
+private:
+	Point size_;
+	std::vector<char> blocked_;	// columns first, then rows
+	std::vector<PushVariation> variations_[16];
+};
+
 template<typename F>
 void ForEachPoint(const Point& size, F fn) {
 	for (int y = 0; y < size.y; ++y) {
@@ -0,0 +1,115 @@
+#include "WorkPool.h"
+#include <algorithm>
+#include <cassert>
+
+namespace {
+
+// The pool and queue of the current thread, if it is a pool thread
+thread_local const WorkPool* current_pool = nullptr;
+thread_local int current_queue = -1;
+
+} // namespace
+
+WorkPool::WorkPool(int threads) {
+	assert(threads > 0);
+	for (int i = 0; i < threads; ++i) {
+		queues_.emplace_back(new Queue);
+	}
+	for (int i = 0; i < threads; ++i) {
+		threads_.emplace_back([this, i] { Work(i); });
+	}
+}
+
+WorkPool::~WorkPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	wake_.notify_all();
+	for (auto& thread : threads_) {
+		thread.join();
+	}
+}
+
+bool WorkPool::Later(const Task& a, const Task& b) {
+	return a.deadline > b.deadline ||
+		(a.deadline == b.deadline && a.order > b.order);
+}
+
+void WorkPool::Submit(Clock::time_point deadline, std::function<void()> task) {
+	auto order = submitted_++;
+	// a task submitted from a pool thread stays on its queue
+	int index = current_pool == this ? current_queue : order % queues_.size();
+	auto& queue = *queues_[index];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.heap.push_back({deadline, order, std::move(task)});
+		std::push_heap(queue.heap.begin(), queue.heap.end(), Later);
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		++pending_;
+	}
+	wake_.notify_one();
+}
+
+bool WorkPool::TryTake(int thread, Task& task) {
+	// find the most urgent top, looking at our own queue first
+	int best = -1;
+	Clock::time_point deadline;
+	std::uint64_t order = 0;
+	for (int i = 0, n = queues_.size(); i < n; ++i) {
+		int index = (thread + i) % n;
+		auto& queue = *queues_[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.heap.empty()) {
+			continue;
+		}
+		const auto& top = queue.heap.front();
+		if (best < 0 || top.deadline < deadline ||
+			(top.deadline == deadline && top.order < order))
+		{
+			best = index;
+			deadline = top.deadline;
+			order = top.order;
+		}
+	}
+	if (best < 0) {
+		return false;
+	}
+
+	// another thread may have taken it meanwhile, then look again
+	auto& queue = *queues_[best];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.heap.empty()) {
+		return false;
+	}
+	std::pop_heap(queue.heap.begin(), queue.heap.end(), Later);
+	task = std::move(queue.heap.back());
+	queue.heap.pop_back();
+	return true;
+}
+
+void WorkPool::Work(int thread) {
+	current_pool = this;
+	current_queue = thread;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			wake_.wait(lock, [&] { return stop_ || pending_ > 0; });
+			if (stop_) {
+				return;
+			}
+		}
+		Task task;
+		if (!TryTake(thread, task)) {
+			std::this_thread::yield();
+			continue;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			--pending_;
+		}
+		task.fn();
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads shared by the solvers of several sessions. Each thread has its own
+// queue, and takes the most urgent task of all the queues, its own first
+// on a tie, so idle threads steal from busy ones and the session whose
+// deadline is nearest gets the threads.
+class WorkPool {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// @param threads	at least one
+	explicit WorkPool(int threads);
+	~WorkPool();
+
+	WorkPool(const WorkPool&) = delete;
+	WorkPool& operator=(const WorkPool&) = delete;
+
+	// Runs task on one of the threads, earlier deadlines first. Tasks are
+	// never interrupted, so long ones should check a CancelToken.
+	void Submit(Clock::time_point deadline, std::function<void()> task);
+
+	int Threads() const { return threads_.size(); }
+
+private:
+	struct Task {
+		Clock::time_point deadline;
+		std::uint64_t order;	// FIFO among equal deadlines
+		std::function<void()> fn;
+	};
+
+	// Orders the heaps, most urgent on top
+	static bool Later(const Task& a, const Task& b);
+
+	struct Queue {
+		std::mutex mutex;
+		std::vector<Task> heap;	// most urgent on top
+	};
+
+	bool TryTake(int thread, Task& task);
+	void Work(int thread);
+
+	std::vector<std::unique_ptr<Queue>> queues_;
+	std::atomic<std::uint64_t> submitted_{0};
+
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	int pending_ = 0;	// tasks in the queues
+	bool stop_ = false;
+
+	std::vector<std::thread> threads_;
+};
@@ -83,18 +83,9 @@ private:
 
 void Game::InitReplay(const std::string& filename) {
 	try {
-		InputParser parser;
-		std::ifstream input(filename);
-		input.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-		auto info = parser.ParseInit(parser.FromStream(input));
-
-		TurnInfo turn;
-		int player_count = 0;
-		while (!(turn = parser.ParseTurn(parser.FromStream(input))).end) {
-			player_count = std::max(player_count, turn.player + 1);
-			replay_.turns.push_back(std::move(turn));
-		}
+		replay_.log.reset(new ReplayLog(filename));
+		const auto& info = replay_.log->Info();
+		int player_count = replay_.log->Players();
 
 		grid_.Init(info.width, info.height, info.displays, player_count);
 		scores_.resize(player_count, 0);
@@ -174,8 +165,10 @@ void Game::SetPlayer(int player) {
 }
 
 void Game::SetReplay(int n) {
-	auto& info = replay_.turns[n];
+	auto turn = replay_.log->Get(n);
+	const auto& info = *turn;
 	replay_.current = n;
+	replay_.log->Prefetch(n);
 
 	player_ = info.player;
 	tick_ = info.tick;
@@ -312,7 +305,7 @@ void Game::RequestNext(bool animate, int n) {
 	}
 
 	if (state_ == State::kReady) {
-		int turns = replay_.turns.size() - 1;
+		int turns = replay_.log->Size() - 1;
 		auto next = std::max(0, std::min(replay_.current + n, turns));
 		ResetColors();
 		if (animate && next > replay_.current) {
@@ -390,11 +383,11 @@ void Game::AnimateReplay() {
 	auto current = replay_.current;
 	auto next = current + 1;
 
-	const auto& src = replay_.turns[current];
-	const auto& dst = replay_.turns[next];
+	auto src = replay_.log->Get(current);
+	auto dst = replay_.log->Get(next);
 
 #if 0
-	auto delta = dst.grid.Diff(src.grid, src.extra, src.player);
+	auto delta = dst->grid.Diff(src->grid, src->extra, src->player);
 
 	state_ = State::kAnimatePush;
 	AnimatePush(delta.edge, delta.extra, State::kAnimateMove);
@@ -460,8 +453,8 @@ void Game::NextPlayer() {
 	SetPlayer(next);
 }
 
-GameState Game::SaveState() {
-	GameState gs;
+UndoState Game::SaveState() {
+	UndoState gs;
 	gs.grid = grid_;
 	gs.scores = scores_;
 	gs.extras = extras_;
@@ -471,7 +464,7 @@ GameState Game::SaveState() {
 	return gs;
 }
 
-void Game::RestoreState(const GameState& gs) {
+void Game::RestoreState(const UndoState& gs) {
 	grid_ = gs.grid;
 	scores_ = gs.scores;
 	extras_ = gs.extras;
@@ -5,6 +5,7 @@
 #include "Solver.h"
 #include "Animation.h"
 #include "InputParser.h"
+#include "ReplayLog.h"
 #include <vector>
 #include <memory>
 #include <SFML/System/Vector2.hpp>
@@ -13,11 +14,11 @@
 
 
 struct ReplayState {
-	std::vector<TurnInfo> turns;
+	std::unique_ptr<ReplayLog> log;
 	int current = 0;
 };
 
-struct GameState {
+struct UndoState {
 	Grid grid;
 	std::vector<int> scores;
 	std::vector<Field> extras;
@@ -86,8 +87,8 @@ private:
 	void AnimateMove(Point move, State end_state);
 
 	bool IsReachable(const Point& pos) const;
-	GameState SaveState();
-	void RestoreState(const GameState& gs);
+	UndoState SaveState();
+	void RestoreState(const UndoState& gs);
 	void RandomizeTargets();
 
 	State state_;
@@ -103,7 +104,7 @@ private:
 
 	Mode mode_ = Mode::kFree;
 	ReplayState replay_;			// only in replay mode
-	std::vector<GameState> undo_;	// only in free mode
+	std::vector<UndoState> undo_;	// only in free mode
 
 	int tick_ = 0;
 	int player_ = 0;
@@ -0,0 +1,131 @@
+#include "ReplayLog.h"
+#include <algorithm>
+
+namespace {
+
+// Turns loaded before and after the one shown
+const int kBehind = 16;
+const int kAhead = 64;
+
+using Lines = std::vector<boost::string_ref>;
+
+} // namespace
+
+ReplayLog::ReplayLog(const std::string& filename) {
+	input_.open(filename, std::ios::binary);
+	if (!input_) {
+		throw std::ifstream::failure("cannot open " + filename);
+	}
+	reader_.reset(new MatchLogReader(input_));
+	info_ = parser_.ParseInit(reader_->Next());
+
+	// one pass, for the offsets and the scores, which add up from the start
+	Lines refs;
+	for (;;) {
+		auto position = reader_->Tell();
+		auto lines = reader_->Next();
+		if (lines.empty()) {
+			// logs cut at the end of the game have no END
+			break;
+		}
+		refs.assign(lines.begin(), lines.end());
+		const auto& turn = parser_.ParseTurn(refs);
+		if (turn.end) {
+			break;
+		}
+		Entry entry;
+		entry.position = std::move(position);
+		entry.scores = turn.scores;
+		entry.score = turn.score;
+		index_.push_back(std::move(entry));
+		players_ = std::max(players_, turn.player + 1);
+	}
+
+	worker_ = std::thread([this] { Work(); });
+}
+
+ReplayLog::~ReplayLog() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	wake_.notify_one();
+	worker_.join();
+}
+
+std::shared_ptr<const TurnInfo> ReplayLog::Get(int n) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = cache_.find(n);
+	if (it != cache_.end()) {
+		return it->second;
+	}
+	return cache_[n] = Load(n);
+}
+
+void ReplayLog::Prefetch(int n) {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		wanted_ = n;
+		cache_.erase(cache_.begin(), cache_.lower_bound(n - kBehind));
+		cache_.erase(cache_.upper_bound(n + kAhead), cache_.end());
+	}
+	wake_.notify_one();
+}
+
+std::shared_ptr<const TurnInfo> ReplayLog::Load(int n) {
+	const auto& entry = index_[n];
+	Lines refs;
+	auto read = [&](int i) -> const TurnInfo& {
+		reader_->Seek(index_[i].position);
+		auto lines = reader_->Next();
+		refs.assign(lines.begin(), lines.end());
+		return parser_.ParseTurn(refs);
+	};
+
+	auto turn = std::make_shared<TurnInfo>();
+	if (entry.score && n > 0) {
+		// the score has the board of the last turn
+		auto grid = read(n - 1).grid;
+		*turn = read(n);
+		turn->grid = std::move(grid);
+	} else {
+		*turn = read(n);
+	}
+	turn->scores = entry.scores;
+	return turn;
+}
+
+void ReplayLog::Work() {
+	std::unique_lock<std::mutex> lock(mutex_);
+	for (;;) {
+		// nearest missing turn, ahead first
+		int next = -1;
+		int last = std::min<int>(wanted_ + kAhead, index_.size() - 1);
+		for (int i = wanted_; i <= last && next < 0; ++i) {
+			if (!cache_.count(i)) {
+				next = i;
+			}
+		}
+		for (int i = wanted_ - 1; i >= std::max(0, wanted_ - kBehind) &&
+			next < 0; --i)
+		{
+			if (!cache_.count(i)) {
+				next = i;
+			}
+		}
+
+		if (stop_) {
+			return;
+		}
+		if (next < 0) {
+			wake_.wait(lock);
+			continue;
+		}
+		cache_[next] = Load(next);
+
+		// let Get in between turns
+		lock.unlock();
+		std::this_thread::yield();
+		lock.lock();
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "InputParser.h"
+#include "MatchLog.h"
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The turns of a match log, indexed on open and read when needed. Only the
+// turns around the one shown are kept; a background thread reads them ahead.
+class ReplayLog {
+public:
+	// @throw	std::ifstream::failure if the log cannot be opened
+	explicit ReplayLog(const std::string& filename);
+	~ReplayLog();
+
+	ReplayLog(const ReplayLog&) = delete;
+	ReplayLog& operator=(const ReplayLog&) = delete;
+
+	const FieldInfo& Info() const { return info_; }
+	int Size() const { return index_.size(); }
+	int Players() const { return players_; }
+
+	// @return	turn n, read now if it isn't loaded yet
+	std::shared_ptr<const TurnInfo> Get(int n);
+
+	// Loads the turns around n in the background, and drops the far ones
+	void Prefetch(int n);
+
+private:
+	struct Entry {
+		MatchLogReader::Position position;
+		std::vector<int> scores;
+		bool score = false;
+	};
+
+	std::shared_ptr<const TurnInfo> Load(int n);	// with mutex_ held
+	void Work();
+
+	std::ifstream input_;
+	std::unique_ptr<MatchLogReader> reader_;
+	InputParser parser_;
+	FieldInfo info_;
+	std::vector<Entry> index_;
+	int players_ = 0;
+
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::map<int, std::shared_ptr<const TurnInfo>> cache_;
+	int wanted_ = 0;
+	bool stop_ = false;
+	std::thread worker_;
+};
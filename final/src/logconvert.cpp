@@ -0,0 +1,34 @@
+#include "MatchLog.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+// Converts a match log between the text and the binary forms. The form of
+// the output is chosen by its name.
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		std::cerr << "usage: " << argv[0] << " <input log> <output log>\n"
+			"  output names ending in .bin get the binary form" << std::endl;
+		return 1;
+	}
+
+	std::ifstream input(argv[1], std::ios::binary);
+	if (!input) {
+		std::cerr << "error: cannot read file: " << argv[1] << std::endl;
+		return 1;
+	}
+	MatchLogReader reader(input);
+
+	{
+		MatchLogWriter writer(argv[2], IsBinaryLogName(argv[2]));
+		std::vector<boost::string_ref> refs;
+		for (auto lines = reader.Next(); !lines.empty(); lines = reader.Next()) {
+			refs.assign(lines.begin(), lines.end());
+			writer.Write(refs);
+		}
+	}
+	return 0;
+}
@@ -1,24 +1,123 @@
 #include "EagerTaxicab.h"
 #include "UpwindSailer.h"
 #include "SuperFill.h"
+#include "RolloutSolver.h"
+#include "DeadlineSolver.h"
+#include "WorkPool.h"
 #include "Client.h"
+#include "Log.h"
 #include <iostream>
 #include <vector>
 #include <cstdlib>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 #include <boost/program_options.hpp>
 
+namespace po = boost::program_options;
+
+namespace {
+
+// One game played by the process
+struct Session {
+	std::string team_name = "the_hypnotoad";
+	std::string password = "******";
+	std::string filename;
+	int level = 0;
+	std::string solver_name = "super";
+	std::string evaluation = "default";
+};
+
+// @return	nullptr if there is no such solver
+std::unique_ptr<Solver> MakeSolver(const std::string& solver_name,
+	const std::string& evaluation, std::shared_ptr<WorkPool> pool)
+{
+	std::unique_ptr<Solver> solver;
+	if (solver_name == "super") {
+		auto names = SuperSolver::Evaluations();
+		if (std::find(names.begin(), names.end(), evaluation) == names.end()) {
+			std::cerr << "error: unknown evaluation: " << evaluation << std::endl;
+			return nullptr;
+		}
+		solver.reset(new SuperSolver{evaluation});
+	} else if (solver_name == "rollout") {
+		solver.reset(new RolloutSolver{std::move(pool)});
+	} else if (solver_name == "eager") {
+		solver.reset(new EagerTaxicab);
+	} else if (solver_name == "upwind") {
+		solver.reset(new UpwindSailer);
+	} else {
+		std::cerr << "error: unknown solver: " << solver_name << std::endl;
+	}
+	return solver;
+}
+
+// @return	the value of session i of an option given once per session, the
+//			last one for the sessions after them
+template<typename T>
+T SessionValue(const po::variables_map& vm, const char* name, int i, T value) {
+	if (vm.count(name)) {
+		const auto& values = vm[name].as<std::vector<T>>();
+		value = values[std::min<std::size_t>(i, values.size() - 1)];
+	}
+	return value;
+}
+
+// @return	filename with the session before its extension, game.log becomes
+//			game.2.log
+std::string SessionFilename(const std::string& filename, int i) {
+	auto slash = filename.rfind('/');
+	auto dot = filename.rfind('.');
+	if (dot == std::string::npos ||
+		(slash != std::string::npos && dot < slash))
+	{
+		dot = filename.size();
+	}
+	return filename.substr(0, dot) + "." + std::to_string(i) +
+		filename.substr(dot);
+}
+
+void Play(const Session& session, const std::string& host_name,
+	unsigned short port, bool verbose, std::chrono::milliseconds budget,
+	std::shared_ptr<WorkPool> pool)
+{
+	// Even without a time limit, so that the client stays responsive
+	std::unique_ptr<Solver> solver{new DeadlineSolver{
+		MakeSolver(session.solver_name, session.evaluation, pool), budget,
+		pool}};
+
+	auto&& client = Client{host_name, port, session.team_name,
+			session.password, session.filename, session.level, verbose};
+	for(;;) {
+		bool end = client.Run(*solver);
+		if (end) {
+			break;
+		}
+	}
+}
+
+} // namespace
+
 
 int main(int argc, char** argv) {
-	namespace po = boost::program_options;
 	po::options_description desc{"Allowed Options"};
 	desc.add_options()
 		("help,h", "this help message")
 		("host,H", po::value<std::string>(), "hostname to connect to, defaults to localhost")
-		("teamname,t", po::value<std::string>(), "teamname to use during login")
-		("password,p", po::value<std::string>(), "password to use for authentication")
-		("level,l", po::value<int>(), "request level (defaults to random)")
-		("output,o", po::value<std::string>(), "file to save server messages")
+		("teamname,t", po::value<std::vector<std::string>>()->composing(), "teamname to use during login")
+		("password,p", po::value<std::vector<std::string>>()->composing(), "password to use for authentication")
+		("level,l", po::value<std::vector<int>>()->composing(), "request level (defaults to random)")
+		("output,o", po::value<std::vector<std::string>>()->composing(), "file to save server messages")
+		("solver,s", po::value<std::vector<std::string>>()->composing(), "super (default), rollout, eager or upwind")
+		("evaluation,e", po::value<std::vector<std::string>>()->composing(), "scoring of the super solver: default, area or blocked")
+		("sessions,n", po::value<int>(), "games played at once, defaults to the most times one of the options above is given; "
+			"the options above may be given once per session, the last one counts for the sessions after them")
+		("threads,j", po::value<int>(), "solver threads shared by the sessions, defaults to the number of cores")
+		("turn-time,T", po::value<int>(), "time limit of a turn in ms (defaults to 1000), 0 disables the deadline")
+		("margin,m", po::value<int>(), "safety margin before the time limit in ms (defaults to 150)")
+		("log-level,L", po::value<std::string>(), "trace, debug (default), info, warning, error or off")
 		("verbose,v", "verbose output to console");
 
 	po::variables_map vm;
@@ -33,11 +132,12 @@ int main(int argc, char** argv) {
 	/* config area */
 	std::string host_name = "localhost";
 	const unsigned short port = 42500;
-	std::string team_name = "the_hypnotoad";
-	std::string password = "******";
-	std::string filename;
 	bool verbose = false;
-	int level = 0;
+	int sessions = 1;
+	int threads = std::max(1u, std::thread::hardware_concurrency());
+	int turn_time = 1000;
+	int margin = 150;
+	logging::Level log_level = logging::Level::kDebug;
 
 	if (vm.count("help")) {
 		std::cout << desc << std::endl;
@@ -48,44 +148,95 @@ int main(int argc, char** argv) {
 		host_name = vm["host"].as<std::string>();
 	}
 
-	if (vm.count("teamname")) {
-		team_name = vm["teamname"].as<std::string>();
+	if (vm.count("verbose")) {
+		verbose = true;
 	}
 
-	if (vm.count("password")) {
-		password = vm["password"].as<std::string>();
+	if (vm.count("log-level")) {
+		auto name = vm["log-level"].as<std::string>();
+		if (!logging::ParseLevel(name, log_level)) {
+			std::cerr << "error: unknown log level: " << name << std::endl;
+			return 1;
+		}
 	}
+	logging::SetLevel(log_level);
 
-	if (vm.count("level")) {
-		level = vm["level"].as<int>();
+	if (vm.count("turn-time")) {
+		turn_time = vm["turn-time"].as<int>();
 	}
 
-	if (vm.count("verbose")) {
-		verbose = true;
+	if (vm.count("margin")) {
+		margin = vm["margin"].as<int>();
 	}
 
-	if (vm.count("output")) {
-		filename = vm["output"].as<std::string>();
-	} else {
+	if (!vm.count("output")) {
 		std::cerr << "error: no output file was specified" << std::endl;
 		return 1;
 	}
 
-#if 0
-	UpwindSailer solver;
-#else
-#if 0
-	EagerTaxicab solver;
-#else
-	SuperSolver solver;
-#endif
-#endif
-	auto&& client = Client{host_name, port, team_name, password, filename, level,
-			verbose};
-	for(;;) {
-		bool end = client.Run(solver);
-		if (end) {
-			break;
+	for (auto name : {"teamname", "password", "output", "solver", "evaluation"}) {
+		if (vm.count(name)) {
+			sessions = std::max<int>(sessions,
+				vm[name].as<std::vector<std::string>>().size());
+		}
+	}
+	if (vm.count("level")) {
+		sessions = std::max<int>(sessions, vm["level"].as<std::vector<int>>().size());
+	}
+	if (vm.count("sessions")) {
+		sessions = vm["sessions"].as<int>();
+	}
+
+	if (vm.count("threads")) {
+		threads = vm["threads"].as<int>();
+	}
+
+	if (sessions < 1 || threads < 1) {
+		std::cerr << "error: sessions and threads must be positive" << std::endl;
+		return 1;
+	}
+
+	std::vector<Session> configs(sessions);
+	const auto& outputs = vm["output"].as<std::vector<std::string>>();
+	for (int i = 0; i < sessions; ++i) {
+		auto& session = configs[i];
+		session.team_name = SessionValue(vm, "teamname", i, session.team_name);
+		session.password = SessionValue(vm, "password", i, session.password);
+		session.level = SessionValue(vm, "level", i, session.level);
+		session.solver_name = SessionValue(vm, "solver", i, session.solver_name);
+		session.evaluation = SessionValue(vm, "evaluation", i, session.evaluation);
+		// the sessions sharing the last output get a file each
+		bool shared = int(outputs.size()) < sessions &&
+			i >= int(outputs.size()) - 1;
+		session.filename = shared ? SessionFilename(outputs.back(), i) :
+			outputs[i];
+		if (!MakeSolver(session.solver_name, session.evaluation, nullptr)) {
+			return 1;
 		}
 	}
+
+	std::chrono::milliseconds budget{0};
+	if (turn_time > 0) {
+		budget = std::chrono::milliseconds(std::max(turn_time - margin, 1));
+	}
+	auto pool = std::make_shared<WorkPool>(threads);
+
+	if (sessions == 1) {
+		Play(configs.front(), host_name, port, verbose, budget, pool);
+		return 0;
+	}
+
+	std::vector<std::thread> games;
+	for (const auto& session : configs) {
+		games.emplace_back([&, session] {
+			try {
+				Play(session, host_name, port, verbose, budget, pool);
+			} catch (std::exception& e) {
+				LOG(kError) << session.team_name << ": " << e.what();
+			}
+		});
+	}
+	for (auto& game : games) {
+		game.join();
+	}
 }
@@ -1,71 +1,270 @@
-#include "Matrix.h"
 #include "InputParser.h"
+#include "MatchLog.h"
 
-#include <sstream>
 #include <iostream>
 #include <fstream>
-#include <iomanip>
 #include <vector>
 #include <map>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+
+#include <boost/program_options.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <boost/optional.hpp>
+#include <glob.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 
 struct Session {
 	std::map<std::string, int> score;
 	std::map<std::string, std::vector<int>> gamescore;
+	std::map<std::string, std::vector<int>> games;	// file of each gamescore
 };
 
+// What a log tells about the scores of its game
+struct GameResult {
+	bool read = false;	// the file has contents
+	bool ok = false;	// the game ended with a SCORE
+	std::vector<std::string> players;
+	std::vector<int> scores;
+};
 
-void UpdateScores(int index, const std::string& filename, Session& session) {
-	try {
-		InputParser parser;
-		std::ifstream input(filename);
-		input.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+namespace {
+
+using Lines = std::vector<boost::string_ref>;
+
+// A file mapped read only, empty if it cannot be
+class MappedFile {
+public:
+	explicit MappedFile(const std::string& filename) {
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if (fd < 0) {
+			return;
+		}
+		struct stat st;
+		if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+			void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data != MAP_FAILED) {
+				::madvise(data, st.st_size, MADV_SEQUENTIAL);
+				data_ = static_cast<const char*>(data);
+				size_ = st.st_size;
+			}
+		}
+		::close(fd);
+	}
+
+	~MappedFile() {
+		if (data_) {
+			::munmap(const_cast<char*>(data_), size_);
+		}
+	}
 
-		auto info = parser.ParseInit(parser.FromStream(input));
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
 
-		TurnInfo turn;
-		int player_count = 0;
-		while (!(turn = parser.ParseTurn(parser.FromStream(input))).score) {}
+	boost::string_ref Contents() const { return {data_, size_}; }
 
-		// assume last player scored
-		turn.scores[turn.player] += 1;
+private:
+	const char* data_ = nullptr;
+	std::size_t size_ = 0;
+};
 
-		int i = -1;
-		for (auto x : turn.scores) {
-			++i;
-			const auto& name = info.player_names[i];
-			auto& score = session.score[name];
+// Follows the messages of a game the way InputParser counts scores: the
+// player of a turn scored if a display is gone in the next one. Only the
+// DISPLAY and PLAYER lines of turns are looked at.
+class ScoreScanner {
+public:
+	// @return	false once the game is over
+	bool Message(const Lines& lines) {
+		if (lines.empty()) {
+			return false;
+		}
+		if (!init_) {
+			std::vector<std::string> strings(lines.begin(), lines.end());
+			result_.players = InputParser().ParseInit(strings).player_names;
+			result_.scores.assign(InputParser::kMaxPlayers, 0);
+			init_ = true;
+			return true;
+		}
+		if (lines.front().starts_with("SCORE")) {
+			// assume last player scored
+			if (player_ >= 0) {
+				result_.scores[player_] += 1;
+			}
+			result_.ok = true;
+			return false;
+		}
+		if (lines.front().starts_with("END")) {
+			return false;
+		}
 
-			score += x;
-			session.gamescore[name].push_back(score);
+		displays_.clear();
+		int player = -1;
+		for (const auto& line : lines) {
+			if (line.starts_with("DISPLAY ")) {
+				displays_.push_back(std::atoi(line.data() + 8));
+			} else if (line.starts_with("PLAYER ")) {
+				player = std::atoi(line.data() + 7);
+			}
+		}
+		std::sort(displays_.begin(), displays_.end());
+		if (player_ >= 0 && !std::includes(displays_.begin(), displays_.end(),
+			prev_displays_.begin(), prev_displays_.end()))
+		{
+			++result_.scores[player_];
 		}
+		if (player < 0 || player >= InputParser::kMaxPlayers) {
+			return false;
+		}
+		player_ = player;
+		std::swap(displays_, prev_displays_);
+		return true;
+	}
 
-		// std::cout << "GAME " << index << std::endl;
-		// for (auto kv : scores) {
-		// 	std::cout << "  " << kv.first << ": " << kv.second << std::endl;
-		// }
+	const GameResult& Result() const { return result_; }
 
-		// std::cout << std::endl;
+private:
+	GameResult result_;
+	bool init_ = false;
+	int player_ = -1;
+	std::vector<int> displays_;
+	std::vector<int> prev_displays_;
+};
+
+GameResult ScanText(boost::string_ref text) {
+	ScoreScanner scanner;
+	Lines lines;
+	while (!text.empty()) {
+		auto end = static_cast<const char*>(
+			std::memchr(text.data(), '\n', text.size()));
+		auto size = end ? end - text.data() : text.size();
+		boost::string_ref line(text.data(), size);
+		text.remove_prefix(end ? size + 1 : size);
+		if (!line.empty() && line.back() == '\r') {
+			line.remove_suffix(1);
+		}
 
-	} catch (std::ifstream::failure ex) {
-		std::cerr << "error: cannot read file: " << filename << std::endl;
-		exit(1);
+		if (line == ".") {
+			if (!scanner.Message(lines)) {
+				break;
+			}
+			lines.clear();
+		} else {
+			lines.push_back(line);
+		}
 	}
+	return scanner.Result();
 }
 
+GameResult ScanBinary(const std::string& filename) {
+	ScoreScanner scanner;
+	std::ifstream input(filename, std::ios::binary);
+	MatchLogReader reader(input);
+	Lines refs;
+	for (auto lines = reader.Next(); !lines.empty(); lines = reader.Next()) {
+		refs.assign(lines.begin(), lines.end());
+		if (!scanner.Message(refs)) {
+			break;
+		}
+	}
+	return scanner.Result();
+}
 
-int main() {
-	Session session;
+GameResult ScanLog(const std::string& filename) {
+	MappedFile file(filename);
+	auto contents = file.Contents();
+	if (contents.empty()) {
+		return {};
+	}
+	if (contents.starts_with(boost::string_ref(
+		kBinaryLogMagic, sizeof(kBinaryLogMagic))))
+	{
+		auto result = ScanBinary(filename);
+		result.read = true;
+		return result;
+	}
+	auto result = ScanText(contents);
+	result.read = true;
+	return result;
+}
 
+// @return	the logs matched by pattern, or inside it if it is a directory,
+//	in order
+std::vector<std::string> ListLogs(const std::string& pattern) {
+	std::vector<std::string> patterns{pattern};
+	struct stat st;
+	if (::stat(pattern.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+		patterns = {pattern + "/*.log", pattern + "/*.bin"};
+	}
+
+	std::vector<std::string> files;
+	for (const auto& p : patterns) {
+		::glob_t paths;
+		if (::glob(p.c_str(), 0, nullptr, &paths) == 0) {
+			files.insert(files.end(), paths.gl_pathv,
+				paths.gl_pathv + paths.gl_pathc);
+		}
+		::globfree(&paths);
+	}
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+std::vector<GameResult> ScanLogs(const std::vector<std::string>& files,
+	int threads)
+{
+	std::vector<GameResult> results(files.size());
+	std::atomic<std::size_t> next{0};
+	auto work = [&] {
+		for (std::size_t i; (i = next++) < files.size();) {
+			results[i] = ScanLog(files[i]);
+		}
+	};
+	std::vector<std::thread> workers;
+	for (int i = 1; i < threads; ++i) {
+		workers.emplace_back(work);
+	}
+	work();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	return results;
+}
+
+void UpdateScores(const GameResult& result, int game, Session& session) {
+	for (int i = 0, ie = result.players.size(); i < ie; ++i) {
+		const auto& name = result.players[i];
+		auto& score = session.score[name];
+
+		score += result.scores[i];
+		session.gamescore[name].push_back(score);
+		session.games[name].push_back(game);
+	}
+}
 
-	for (int i = 1; i <= 15; ++i) {
-		std::stringstream ss;
-		ss << std::setfill('0') << std::setw(2) << i;
-		auto fname = "games/game_" + ss.str() + ".log";
-		// std::cout << fname << std::endl;
-		UpdateScores(i, fname, session);
+// @return	the running score of each team after every file, none where
+//			the team didn't play
+std::map<std::string, std::vector<boost::optional<int>>> ScoresByFile(
+	const Session& session, std::size_t files)
+{
+	std::map<std::string, std::vector<boost::optional<int>>> scores;
+	for (const auto& p : session.gamescore) {
+		auto& row = scores[p.first];
+		row.resize(files);
+		const auto& games = session.games.at(p.first);
+		for (std::size_t i = 0; i < games.size(); ++i) {
+			row[games[i]] = p.second[i];
+		}
 	}
+	return scores;
+}
 
+void PrintTable(const Session& session) {
 	for (const auto& p : session.gamescore) {
 		std::cout << p.first;
 		for (auto x : p.second) {
@@ -74,3 +273,142 @@ int main() {
 		std::cout << std::endl;
 	}
 }
+
+void PrintCsv(const Session& session, const std::vector<std::string>& files) {
+	std::cout << "team";
+	for (const auto& file : files) {
+		std::cout << "," << file;
+	}
+	std::cout << "\n";
+	for (const auto& p : ScoresByFile(session, files.size())) {
+		std::cout << p.first;
+		for (const auto& x : p.second) {
+			std::cout << ",";
+			if (x) {
+				std::cout << *x;
+			}
+		}
+		std::cout << "\n";
+	}
+}
+
+void PrintJson(const Session& session, const std::vector<std::string>& files) {
+	auto quote = [](const std::string& s) {
+		std::string quoted = "\"";
+		for (char c : s) {
+			if (c == '"' || c == '\\') {
+				quoted += '\\';
+			}
+			quoted += c;
+		}
+		return quoted + '"';
+	};
+
+	std::cout << "{\n  \"games\": [";
+	for (std::size_t i = 0; i < files.size(); ++i) {
+		std::cout << (i ? ", " : "") << quote(files[i]);
+	}
+	std::cout << "],\n  \"scores\": {";
+	bool first = true;
+	for (const auto& p : ScoresByFile(session, files.size())) {
+		std::cout << (first ? "\n" : ",\n") << "    " << quote(p.first) << ": [";
+		for (std::size_t i = 0; i < p.second.size(); ++i) {
+			std::cout << (i ? ", " : "");
+			if (p.second[i]) {
+				std::cout << *p.second[i];
+			} else {
+				std::cout << "null";
+			}
+		}
+		std::cout << "]";
+		first = false;
+	}
+	std::cout << "\n  }\n}" << std::endl;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+	namespace po = boost::program_options;
+	po::options_description desc{"Allowed Options"};
+	desc.add_options()
+		("help,h", "this help message")
+		("logs", po::value<std::vector<std::string>>(), "log files, globs or directories, defaults to games/*.log")
+		("format,f", po::value<std::string>(), "table (default), csv or json")
+		("jobs,j", po::value<int>(), "files read at once, defaults to the number of cores");
+	po::positional_options_description positional;
+	positional.add("logs", -1);
+
+	po::variables_map vm;
+	try {
+		po::store(po::command_line_parser(argc, argv)
+			.options(desc).positional(positional).run(), vm);
+		po::notify(vm);
+	} catch(std::exception& e) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return 1;
+	}
+
+	if (vm.count("help")) {
+		std::cout << "usage: " << argv[0] << " [options] [logs...]\n"
+			<< desc << std::endl;
+		return 0;
+	}
+
+	std::vector<std::string> patterns{"games/*.log"};
+	std::string format = "table";
+	int jobs = std::max(1u, std::thread::hardware_concurrency());
+
+	if (vm.count("logs")) {
+		patterns = vm["logs"].as<std::vector<std::string>>();
+	}
+	if (vm.count("format")) {
+		format = vm["format"].as<std::string>();
+		if (format != "table" && format != "csv" && format != "json") {
+			std::cerr << "error: unknown format: " << format << std::endl;
+			return 1;
+		}
+	}
+	if (vm.count("jobs")) {
+		jobs = std::max(1, vm["jobs"].as<int>());
+	}
+
+	// games count in the order of the arguments, and by name within each
+	std::vector<std::string> files;
+	for (const auto& pattern : patterns) {
+		auto matched = ListLogs(pattern);
+		if (matched.empty()) {
+			std::cerr << "error: no logs match: " << pattern << std::endl;
+			return 1;
+		}
+		files.insert(files.end(), matched.begin(), matched.end());
+	}
+
+	auto results = ScanLogs(files, jobs);
+
+	// crashed or unfinished games are left out
+	Session session;
+	std::vector<std::string> games;
+	for (std::size_t i = 0; i < files.size(); ++i) {
+		if (!results[i].read) {
+			std::cerr << "warning: cannot read file, skipped: " << files[i] <<
+				std::endl;
+			continue;
+		}
+		if (!results[i].ok) {
+			std::cerr << "warning: no SCORE, skipped: " << files[i] << std::endl;
+			continue;
+		}
+		UpdateScores(results[i], games.size(), session);
+		games.push_back(files[i]);
+	}
+
+	if (format == "csv") {
+		PrintCsv(session, games);
+	} else if (format == "json") {
+		PrintJson(session, games);
+	} else {
+		PrintTable(session);
+	}
+}
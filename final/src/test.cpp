@@ -1,8 +1,18 @@
 #include "FloodFill.h"
+#include "Grid.h"
+#include "PersistentGrid.h"
+#include "Util.h"
 #include "Field.h"
+#include "InputParser.h"
+#include "MatchLog.h"
 #include <cstdlib>
 #include <iostream>
+#include <fstream>
 #include <chrono>
+#include <string>
+#include <vector>
+#include <glob.h>
+#include <malloc.h>
 
 Matrix<Field> WorstCaseMap(int w, int h) {
 	Matrix<Field> field(15, 15, Field(10));
@@ -30,6 +40,298 @@ int TestFloodFillTime() {
 	return sum;
 }
 
-int main() {
+int TestPlayersFloodFillTime() {
+	Grid grid;
+	grid.Init(15, 15, 10, 10);
+	grid.Randomize();
+	const auto& positions = grid.Positions();
+
+	int sum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < 10000; ++i) {
+		for (const auto& pos : positions) {
+			sum += FloodFill(grid.Fields(), pos).At(0, 0);
+		}
+	}
+	auto middle = std::chrono::steady_clock::now();
+	for (int i = 0; i < 10000; ++i) {
+		sum += PlayersFloodFill(grid.Fields(), positions).At(0, 0);
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	using MilliSec = std::chrono::milliseconds;
+	std::cout << "FloodFill per player took " <<
+		std::chrono::duration_cast<MilliSec>(middle - start).count() <<
+		"ms, PlayersFloodFill took " <<
+		std::chrono::duration_cast<MilliSec>(end - middle).count() <<
+		"ms" << std::endl;
+
+	return sum;
+}
+
+// Compares PlayersFloodFill with a FloodFill per player, on players off the
+// board, on the same cell and elsewhere in the same component
+// @return	the number of cells and players that differ
+int TestPlayersFloodFill() {
+	int mismatches = 0;
+	for (int game = 0; game < 200; ++game) {
+		Grid grid;
+		grid.Init(7 + rand() % 9, 7 + rand() % 9, 10, 2 + rand() % 7);
+		grid.Randomize();
+		const auto& fields = grid.Fields();
+		auto positions = grid.Positions();
+		for (std::size_t i = 1; i < positions.size(); ++i) {
+			const auto& other = positions[rand() % i];
+			switch (rand() % 4) {
+			case 0:
+				positions[i] = {-1, -1};
+				break;
+			case 1:
+				positions[i] = other;
+				break;
+			case 2:
+				if (other.x >= 0) {
+					auto fill = FloodFill(fields, other);
+					std::vector<Point> reachable;
+					for (int y = 0; y < fill.Height(); ++y) {
+						for (int x = 0; x < fill.Width(); ++x) {
+							if (fill.At(x, y)) {
+								reachable.emplace_back(x, y);
+							}
+						}
+					}
+					positions[i] = reachable[rand() % reachable.size()];
+				}
+				break;
+			}
+		}
+
+		Arena arena;
+		auto players = PlayersFloodFill(fields, positions);
+		auto players_arena = PlayersFloodFill(fields, positions, &arena);
+		for (std::size_t i = 0; i < positions.size(); ++i) {
+			Matrix<int> fill{fields.Width(), fields.Height(), 0};
+			if (positions[i].x >= 0) {
+				fill = FloodFill(fields, positions[i]);
+			}
+			for (int y = 0; y < fields.Height(); ++y) {
+				for (int x = 0; x < fields.Width(); ++x) {
+					bool reached = fill.At(x, y) != 0;
+					if (reached != bool(players.At(x, y) >> i & 1) ||
+						reached != bool(players_arena.At(x, y) >> i & 1))
+					{
+						++mismatches;
+					}
+				}
+			}
+		}
+	}
+
+	std::cout << "PlayersFloodFill differs from FloodFill on " << mismatches <<
+		" cells" << std::endl;
+	return mismatches;
+}
+
+int TestPushTime() {
+	Grid grid;
+	grid.Init(15, 15, 10, 4);
+	grid.Randomize();
+	auto variations = GetPushVariations(grid, Field(10));
+
+	int sum = 0;
+	const int pushes = 1000000;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < pushes; ++i) {
+		const auto& v = variations[rand() % variations.size()];
+		auto extra = grid.Push(v.edge, v.tile);
+		sum += extra;
+		grid.Push(v.opposite_edge, extra);
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+	std::cout << "Push took " << ms << "ms, " <<
+		(ms ? 2 * pushes / ms : 0) << " pushes/ms" << std::endl;
+
+	return sum;
+}
+
+// Holds every board two pushes away at once, as a search over siblings would.
+// The best of a few passes is timed, so that neither type pays for the heap
+// growing first, and the heap held by the boards is measured.
+template<typename G, typename PushFunc>
+int TestSiblingsTime(const char* name, const Grid& grid, PushFunc push) {
+	std::chrono::steady_clock::duration best = std::chrono::hours(1);
+	std::size_t boards = 0;
+	std::size_t bytes = 0;
+	int sum = 0;
+	for (int pass = 0; pass < 5; ++pass) {
+		auto heap = ::mallinfo2().uordblks;
+		auto start = std::chrono::steady_clock::now();
+		std::vector<G> level{G(grid)};
+		std::vector<Field> extras{Field(10)};
+		for (int depth = 0; depth < 2; ++depth) {
+			std::vector<G> next_level;
+			std::vector<Field> next_extras;
+			for (int i = 0, ie = level.size(); i < ie; ++i) {
+				for (const auto& v : GetPushVariations(grid, extras[i])) {
+					G next;
+					Field extra;
+					std::tie(next, extra) = push(level[i], v);
+					next_level.push_back(std::move(next));
+					next_extras.push_back(extra);
+				}
+			}
+			level = std::move(next_level);
+			extras = std::move(next_extras);
+		}
+		best = std::min(best, std::chrono::steady_clock::now() - start);
+		boards = level.size();
+		bytes = ::mallinfo2().uordblks - heap;
+		sum += level.back().At(0, 0);
+	}
+
+	std::cout << name << " siblings took " <<
+		std::chrono::duration_cast<std::chrono::milliseconds>(best).count() <<
+		"ms for " << boards << " boards, " << bytes / boards <<
+		" bytes per board" << std::endl;
+
+	return sum;
+}
+
+int TestSiblingsTime() {
+	Grid grid;
+	grid.Init(15, 15, 10, 4);
+	grid.Randomize();
+
+	int sum = TestSiblingsTime<Grid>("Grid", grid,
+		[](const Grid& parent, const PushVariation& v) {
+			Grid next = parent;
+			auto extra = next.Push(v.edge, v.tile);
+			return std::make_tuple(std::move(next), extra);
+		});
+	sum += TestSiblingsTime<PersistentGrid>("PersistentGrid", grid,
+		[](const PersistentGrid& parent, const PushVariation& v) {
+			return parent.Push(v.edge, v.tile);
+		});
+	return sum;
+}
+
+// Pushes random siblings of random boards on both Grid and PersistentGrid
+// @return	the number of boards that differ
+int TestPersistentGrid() {
+	struct Board {
+		Grid grid;
+		PersistentGrid persistent;
+		Field extra;
+	};
+
+	int mismatches = 0;
+	for (int game = 0; game < 20; ++game) {
+		Grid grid;
+		grid.Init(7 + rand() % 9, 7 + rand() % 9, 10, 4);
+		grid.Randomize();
+		grid.RandomizeBlocked(rand() % 3);
+		std::vector<Board> boards{{grid, PersistentGrid(grid), Field(10)}};
+
+		for (int i = 0; i < 500; ++i) {
+			Board next = boards[rand() % boards.size()];
+			auto variations = GetPushVariations(next.grid, next.extra);
+			const auto& v = variations[rand() % variations.size()];
+			Field extra;
+			std::tie(next.persistent, extra) = next.persistent.Push(v.edge, v.tile);
+			next.extra = next.grid.Push(v.edge, v.tile);
+
+			if (extra != next.extra ||
+				!(next.persistent.Fields() == next.grid.Fields()) ||
+				next.persistent.Displays() != next.grid.Displays() ||
+				next.persistent.Positions() != next.grid.Positions())
+			{
+				++mismatches;
+			}
+			boards.push_back(std::move(next));
+		}
+	}
+
+	std::cout << "PersistentGrid differs from Grid on " << mismatches <<
+		" boards" << std::endl;
+	return mismatches;
+}
+
+using Message = std::vector<std::string>;
+
+std::vector<std::vector<Message>> LoadLogs(const std::string& pattern) {
+	std::vector<std::vector<Message>> logs;
+	::glob_t paths;
+	if (::glob(pattern.c_str(), 0, nullptr, &paths) != 0) {
+		return logs;
+	}
+	for (std::size_t i = 0; i < paths.gl_pathc; ++i) {
+		std::ifstream input(paths.gl_pathv[i], std::ios::binary);
+		MatchLogReader reader(input);
+		std::vector<Message> messages;
+		for (auto lines = reader.Next(); !lines.empty(); lines = reader.Next()) {
+			messages.push_back(std::move(lines));
+		}
+		logs.push_back(std::move(messages));
+	}
+	::globfree(&paths);
+	return logs;
+}
+
+int TestParseTime(const std::string& pattern) {
+	auto logs = LoadLogs(pattern);
+	if (logs.empty()) {
+		std::cout << "No logs at " << pattern << std::endl;
+		return 0;
+	}
+
+	// as the client gets them
+	std::vector<std::vector<std::vector<boost::string_ref>>> lines;
+	for (const auto& messages : logs) {
+		lines.emplace_back();
+		for (const auto& message : messages) {
+			lines.back().emplace_back(message.begin(), message.end());
+		}
+	}
+
+	const int passes = 20;
+	int turns = 0;
+	int sum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int pass = 0; pass < passes; ++pass) {
+		for (const auto& messages : logs) {
+			InputParser parser;
+			parser.ParseInit(messages.front());
+			const auto& turn_lines = lines[&messages - &logs.front()];
+			for (std::size_t i = 1; i < messages.size(); ++i) {
+				const auto& turn = parser.ParseTurn(turn_lines[i]);
+				if (turn.end || turn.score) {
+					break;
+				}
+				sum += turn.player;
+				++turns;
+			}
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	std::chrono::duration<double> seconds = end - start;
+	std::cout << "ParseTurn parsed " << turns << " turns in " <<
+		std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() <<
+		"ms, " << int(turns / seconds.count()) << " turns/s" << std::endl;
+
+	return sum;
+}
+
+int main(int argc, char** argv) {
+	std::string logs = argc > 1 ? argv[1] : "games/*.log";
+
+	std::cout << TestParseTime(logs) << std::endl;
 	std::cout << TestFloodFillTime() << std::endl;
+	std::cout << TestPlayersFloodFillTime() << std::endl;
+	std::cout << TestPlayersFloodFill() << std::endl;
+	std::cout << TestPushTime() << std::endl;
+	std::cout << TestSiblingsTime() << std::endl;
+	std::cout << TestPersistentGrid() << std::endl;
 }